@@ -0,0 +1,19 @@
+; Register-only arithmetic: ADD, AND and NOT in a counted loop
+.ORIG x3000
+LD R1,OUTER
+LOOP1: LD R2,INNER
+LOOP2: ADD R3,R3,R2
+ADD R4,R4,R3
+AND R5,R4,R3
+NOT R5,R5
+ADD R6,R5,#7
+AND R6,R6,#15
+ADD R3,R3,R6
+ADD R2,R2,#-1
+BRp LOOP2
+ADD R1,R1,#-1
+BRp LOOP1
+HALT
+OUTER: .FILL #500
+INNER: .FILL #10000
+.END
@@ -0,0 +1,29 @@
+; Data-dependent branches on the bits of a linear congruential sequence
+.ORIG x3000
+LD R1,OUTER
+AND R5,R5,#0
+LOOP1: LD R2,INNER
+LOOP2: ADD R6,R5,R5
+ADD R6,R6,R6
+ADD R5,R6,R5
+ADD R5,R5,#1
+AND R0,R5,#1
+BRz BIT1
+ADD R3,R3,#1
+BIT1: AND R0,R5,#2
+BRz BIT2
+ADD R4,R4,#1
+BIT2: AND R0,R5,#4
+BRnp BIT3
+ADD R3,R3,#-1
+BIT3: AND R0,R5,#8
+BRz NEXT
+ADD R4,R4,#-1
+NEXT: ADD R2,R2,#-1
+BRp LOOP2
+ADD R1,R1,#-1
+BRp LOOP1
+HALT
+OUTER: .FILL #300
+INNER: .FILL #10000
+.END
@@ -0,0 +1,32 @@
+; Loads and stores: fill and sum an array, then update a word through a pointer
+.ORIG x3000
+LEA R0,ARRAY
+ST R0,PTR
+LD R1,PASSES
+PASS: LEA R2,ARRAY
+LD R3,SIZE
+FILL: STR R3,R2,#0
+ADD R2,R2,#1
+ADD R3,R3,#-1
+BRp FILL
+LEA R2,ARRAY
+LD R3,SIZE
+AND R4,R4,#0
+SUM: LDR R5,R2,#0
+ADD R4,R4,R5
+ADD R2,R2,#1
+ADD R3,R3,#-1
+BRp SUM
+ST R4,TOTAL
+LDI R5,PTR
+ADD R5,R5,R4
+STI R5,PTR
+ADD R1,R1,#-1
+BRp PASS
+HALT
+PASSES: .FILL #5000
+SIZE: .FILL #1024
+TOTAL: .FILL #0
+PTR: .FILL #0
+ARRAY: .BLKW 1024
+.END
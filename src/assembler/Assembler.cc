@@ -1,4 +1,8 @@
 #include "Assembler.hh"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
 #include <stdexcept>
 
 enum Opcode
@@ -42,112 +46,224 @@ enum Traps
 	HALT
 };
 
-Assembler::Assembler( const char* name ) : filename( name ) { }
+enum Directive
+{
+	ORIG,
+	FILL,
+	BLKW,
+	STRINGZ,
+	END
+};
+
+enum Shape
+{
+	NONE,
+	LABEL9,
+	LABEL11,
+	BASE_REG,
+	TRAP_VECTOR,
+	REG_LABEL9,
+	REG_REG,
+	REG_REG_ARG,
+	REG_REG_OFFSET6,
+	DIRECTIVE
+};
+
+struct Mnemonic
+{
+	const char* name;
+	Shape shape;
+	unsigned short bits;
+};
+
+static constexpr Mnemonic mnemonics[] =
+{
+	{ "BR", LABEL9, BR << 12 | BRnzp },
+	{ "BRnzp", LABEL9, BR << 12 | BRnzp },
+	{ "BRp", LABEL9, BR << 12 | BRp },
+	{ "BRz", LABEL9, BR << 12 | BRz },
+	{ "BRn", LABEL9, BR << 12 | BRn },
+	{ "BRzp", LABEL9, BR << 12 | BRzp },
+	{ "BRnp", LABEL9, BR << 12 | BRnp },
+	{ "BRnz", LABEL9, BR << 12 | BRnz },
+	{ "ADD", REG_REG_ARG, ADD << 12 },
+	{ "AND", REG_REG_ARG, AND << 12 },
+	{ "NOT", REG_REG, NOT << 12 | 0x3F },
+	{ "LD", REG_LABEL9, LD << 12 },
+	{ "LDI", REG_LABEL9, LDI << 12 },
+	{ "LEA", REG_LABEL9, LEA << 12 },
+	{ "ST", REG_LABEL9, ST << 12 },
+	{ "STI", REG_LABEL9, STI << 12 },
+	{ "LDR", REG_REG_OFFSET6, LDR << 12 },
+	{ "STR", REG_REG_OFFSET6, STR << 12 },
+	{ "JSR", LABEL11, JSR << 12 | 1 << 11 },
+	{ "JSRR", BASE_REG, JSR << 12 },
+	{ "JMP", BASE_REG, JMP << 12 },
+	{ "RET", NONE, JMP << 12 | 7 << 6 },
+	{ "RTI", NONE, RTI << 12 },
+	{ "RES", NONE, RES << 12 },
+	{ "TRAP", TRAP_VECTOR, TRAP << 12 },
+	{ "GETC", NONE, TRAP << 12 | GETC },
+	{ "OUT", NONE, TRAP << 12 | OUT },
+	{ "PUTS", NONE, TRAP << 12 | PUTS },
+	{ "IN", NONE, TRAP << 12 | IN },
+	{ "PUTSP", NONE, TRAP << 12 | PUTSP },
+	{ "HALT", NONE, TRAP << 12 | HALT },
+	{ ".ORIG", DIRECTIVE, ORIG },
+	{ ".FILL", DIRECTIVE, FILL },
+	{ ".BLKW", DIRECTIVE, BLKW },
+	{ ".STRINGZ", DIRECTIVE, STRINGZ },
+	{ ".END", DIRECTIVE, END }
+};
 
-std::istream&
-Assembler::getCommand( std::istream& stream, std::string& str )
+static constexpr int operandCounts[] = { 0, 1, 1, 1, 1, 2, 2, 3, 3, 0 };
+
+enum
+{
+	MNEMONIC_COUNT = sizeof( mnemonics ) / sizeof( mnemonics[0] ),
+	HASH_BITS = 7,
+	SEED_LIMIT = 100000
+};
+
+struct HashTable
 {
-	char c;
-	str.clear();
-	while ( stream.get( c ) && c != '\n' )
+	unsigned int seed;
+	signed char slots[1 << HASH_BITS];
+};
+
+static constexpr unsigned int
+hashName( const unsigned int seed, const char* s, const size_t len )
+{
+	unsigned int h = seed;
+	for ( size_t i = 0; i < len; i++ )
 	{
-		if ( c == ';' )
-		{
-			while ( stream.get() != '\n' );
-			break;	
-		}
-		else
-		{
-			str.push_back( c );
-		}
+		h = ( h ^ static_cast<unsigned char>( s[i] ) ) * 16777619u;
 	}
-	return stream;
+	return h >> ( 32 - HASH_BITS );
 }
 
-bool
-Assembler::isNotWhiteSpace( const std::string& str )
+static constexpr size_t
+nameLength( const char* s )
 {
-	for ( const char& c : str )
+	size_t len = 0;
+	while ( s[len] )
 	{
-		if ( c != ' ' && c != '\t' )
+		len++;
+	}
+	return len;
+}
+
+static constexpr HashTable
+makeHashTable()
+{
+	for ( unsigned int seed = 1; seed < SEED_LIMIT; seed++ )
+	{
+		HashTable t = { seed, {} };
+		for ( signed char& slot : t.slots )
+		{
+			slot = -1;
+		}
+		bool perfect = true;
+		for ( int i = 0; i < MNEMONIC_COUNT && perfect; i++ )
+		{
+			const unsigned int h = hashName( seed, mnemonics[i].name, nameLength( mnemonics[i].name ) );
+			perfect = t.slots[h] < 0;
+			t.slots[h] = i;
+		}
+		if ( perfect )
 		{
-			return true;
+			return t;
 		}
 	}
-	return false;
+	return HashTable{ 0, {} };
 }
 
+static constexpr HashTable hashTable = makeHashTable();
+
+static_assert( hashTable.seed != 0, "No perfect hash for the mnemonic table" );
+
+static const Mnemonic*
+lookup( const std::string_view s )
+{
+	const int i = hashTable.slots[hashName( hashTable.seed, s.data(), s.size() )];
+	return i >= 0 && s == mnemonics[i].name ? &mnemonics[i] : NULL;
+}
+
+Assembler::Assembler( const char* name ) : filename( name ), source( name ) { }
+
 void
 Assembler::toTokens()
 {
-	std::ifstream f;
-	f.open( filename );
-	std::string str;
+	const std::string_view text = source.getText();
 	int x = 1;
 	int y = 0;
-	while ( getCommand( f, str ) )
+	size_t pos = 0;
+	while ( pos < text.length() )
 	{
-		if ( isNotWhiteSpace( str ) )
+		size_t end = text.find( '\n', pos );
+		if ( end == std::string_view::npos )
+		{
+			end = text.length();
+		}
+		const std::string_view str = text.substr( pos, std::min( end, text.find( ';', pos ) ) - pos );
+		const size_t first = arena.size();
+		Command::toTokens( str, arena );
+		if ( arena.size() > first )
 		{
-			Command cmd = Command( str, x, y );
-			tokens.push_back( cmd );
+			tokens.emplace_back( str, x, y, first, arena.size() - first, arena );
 			y++;
 		}
+		pos = end + 1;
 		x++;
 	}
+	for ( Command& cmd : tokens )
+	{
+		cmd.tokens = arena.data() + cmd.first;
+	}
 }
 
-void
-Assembler::checkLiteral( const Command& cmd, const std::string& s )
+bool
+Assembler::parseNumber( const std::string_view s, const int base, long& val )
 {
-	try 
-	{ 
-		std::stoi( s, 0, 0 );
-	}
-	catch( std::invalid_argument const& ex )
+	if ( s.length() >= NUMBER_SIZE )
 	{
-		try
-		{
-			std::stoi( s, 0, 2 );	
-		}
-		catch( std::invalid_argument const& ex )
-		{
-			errorMessage( cmd, "Invalid literal: " + s ); 
-		}
+		return false;
 	}
+	char str[NUMBER_SIZE];
+	s.copy( str, s.length() );
+	str[s.length()] = '\0';
+	char* end;
+	val = std::strtol( str, &end, base );
+	return end != str;
 }
 
 int
-Assembler::convertNumber( const Command& cmd, const std::string& s )
+Assembler::convertNumber( const Command& cmd, const std::string_view s )
 {
-	std::string str = s;
-	bool binary = false;
-	if ( s[0] == '#' )
+	const bool binary = s[0] == 'b';
+	const bool hex = s[0] == 'x';
+	const std::string_view str = s.substr( s[0] == '#' || binary || hex ? 1 : 0 );
+	if ( hex && ( str.empty() || !std::isxdigit( static_cast<unsigned char>( str[0] ) ) ) )
 	{
-		str = s.substr( 1, s.length() - 1 );
+		return 0;
 	}
-	else if ( s[0] == 'x' )
+	long val;
+	if ( !parseNumber( str, binary ? 2 : hex ? 16 : 0, val ) )
 	{
-		str = "0x" + s.substr( 1, s.length() - 1 );
+		errorMessage( cmd, "Invalid literal: " + std::string( s ) );
 	}
-	else if ( s[0] == 'b' )
-	{
-		str = s.substr( 1, s.length() - 1 );
-		binary = true;
-	}
-	checkLiteral( cmd, str );
-	return binary ? std::stoi( str, 0, 2 ) : std::stoi( str, 0, 0 );
+	return val;
 }
 
 void
 Assembler::checkOrig()
 {
-	const std::vector<std::string> fst = tokens[0].tokens;
+	const std::string_view* fst = tokens[0].tokens;
 	if ( fst[0] != ".ORIG" )
 	{
 		errorMessage( tokens[0], "First command must be an .ORIG directive" );
 	}
-	else if ( fst.size() != 2 )
+	else if ( tokens[0].count != 2 )
 	{
 		errorMessage( tokens[0], ".ORIG requires one argument" );
 	}
@@ -162,12 +278,12 @@ Assembler::checkOrig()
 void
 Assembler::checkEnd()
 {
-	const std::vector<std::string> end = tokens[tokens.size() - 1].tokens;
+	const std::string_view* end = tokens[tokens.size() - 1].tokens;
 	if ( end[0] != ".END" )
 	{
 		errorMessage( tokens[tokens.size() - 1], "Last command must be an .END directive" );
 	}
-	else if ( end.size() != 1 )
+	else if ( tokens[tokens.size() - 1].count != 1 )
 	{
 		errorMessage( tokens[tokens.size() - 1], ".END requires no arguments" );
 	}
@@ -179,31 +295,31 @@ Assembler::buildTable()
 	int j = start;
 	for ( std::vector<Command>::size_type i = 1; i < tokens.size(); i++ )
 	{
-		const Command cmd = tokens[i];
-		const std::vector<std::string> v = cmd.tokens;
+		const Command& cmd = tokens[i];
+		const std::string_view* v = cmd.tokens;
 		if ( cmd.isLabel )
 		{
-			const std::string label = v[0].substr( 0, v[0].length() - 1 );
-			symbolTable.insert( std::pair<std::string, int>( label, j ) );
+			symbolTable.insert( v[0].substr( 0, v[0].length() - 1 ), j );
 		}
 		if ( cmd.isDirective )
 		{
-			const std::string dir = cmd.isLabel ? v[1] : v[0];
-			if ( dir == ".FILL" )
+			const std::string_view dir = cmd.isLabel ? v[1] : v[0];
+			const Mnemonic* m = lookup( dir );
+			if ( !m || m->shape != DIRECTIVE )
 			{
-				j++;
+				errorMessage( cmd, "Invalid directive: " + std::string( dir ) );
 			}
-			else if ( dir == ".BLKW" )
+			else if ( m->bits == FILL )
 			{
-				j += std::stoi( v[v.size() - 1] );
+				j++;
 			}
-			else if ( dir == ".STRINGZ" )
+			else if ( m->bits == BLKW )
 			{
-				j += v[v.size() - 1].length() + 1;	
+				j += getCount( cmd );
 			}
-			else if ( dir != ".ORIG" && dir != ".END" )
+			else if ( m->bits == STRINGZ )
 			{
-				errorMessage( cmd, "Invalid directive: " + dir );
+				j += v[cmd.count - 1].length() + 1;	
 			}
 		}
 		else
@@ -213,6 +329,17 @@ Assembler::buildTable()
 	}
 }
 
+int
+Assembler::getCount( const Command& cmd )
+{
+	long val;
+	if ( !parseNumber( cmd.tokens[cmd.count - 1], 10, val ) )
+	{
+		errorMessage( cmd, "Invalid count: " + std::string( cmd.tokens[cmd.count - 1] ) );
+	}
+	return val;
+}
+
 void
 Assembler::firstPass()
 {
@@ -240,6 +367,21 @@ Assembler::secondPass()
 		handleTokens( tokens[i], f );
 	}
 	f.close();
+	writeSymbols( inName.substr( 0, inName.rfind( '.' ) ) + ".sym" );
+}
+
+void
+Assembler::writeSymbols( const std::string& outName )
+{
+	std::ofstream f;
+	f.open( outName );
+	f << "// Symbol table\n// Scope level 0:\n//\tSymbol Name       Page Address\n//\t----------------  ------------\n";
+	for ( const std::pair<std::string, int>& symbol : symbolTable.sorted() )
+	{
+		f << "//\t" << std::left << std::setw( 16 ) << symbol.first << "  " << std::right << std::hex << std::uppercase
+			<< std::setfill( '0' ) << std::setw( 4 ) << ( symbol.second & 0xFFFF ) << std::setfill( ' ' ) << '\n';
+	}
+	f.close();
 }
 
 void
@@ -248,276 +390,148 @@ Assembler::handleTokens( const Command& cmd, std::ofstream& stream )
 	if ( cmd.isDirective )
 	{
 		handleDirectives( cmd, stream );
-	} 
-	else
+		return;
+	}
+	const int i = cmd.isLabel ? 1 : 0;
+	const std::string_view fst = cmd.tokens[i];
+	const Mnemonic* m = lookup( fst );
+	if ( !m || m->shape == DIRECTIVE )
 	{
-		const int i = cmd.isLabel ? 1 : 0;
-		const std::string fst = cmd.tokens[i];
-		const int opcode = getOpcode( cmd, fst );
-		const unsigned short opbit = 1 << opcode;
-		int args = 1;
-		if ( opbit & 0xE2 )
+		errorMessage( cmd, "Unknown Command: " + std::string( fst ) );
+	}
+	argumentsCheck( cmd, fst, cmd.count - 1 - i, operandCounts[m->shape] );
+	const std::string_view* args = cmd.tokens + i + 1;
+	unsigned short val = m->bits;
+	switch ( m->shape )
+	{
+		case LABEL9:
 		{
-			args = 4;
+			val |= getOffset( cmd, args[0], 9 );
+			break;
 		}
-		else if ( opbit & 0x4E0C )
+		case LABEL11:
 		{
-			args = 3;
+			val |= getOffset( cmd, args[0], 11 );
+			break;
 		}
-		else if ( opbit & 0x1011 || fst == "TRAP" )
+		case BASE_REG:
 		{
-			args = 2;
+			val |= getRegister( cmd, args[0] ) << 6;
+			break;
 		}
-		argumentsCheck( cmd, fst, cmd.tokens.size() - 1 - i, args - 1 );
-		short r0, r1, r2, target;
-		unsigned short val = opcode << 12;
-		if ( opbit & 0x5EEE || fst == "JSRR" )
+		case TRAP_VECTOR:
 		{
-			registerCheck( cmd, cmd.tokens[i + 1] );
-			r0 = std::stoi( std::string( 1, cmd.tokens[i + 1][1] ) );
-			const int shift = fst == "JSRR" || fst == "JMP" ? 6 : 9;
-			val |= r0 << shift;
+			const unsigned short tv = convertNumber( cmd, args[0] );
+			checkOperand( cmd, tv, 8, false );
+			val |= tv;
+			break;
 		}
-		if ( opbit & 0x2E2 )
+		case REG_LABEL9:
 		{
-			registerCheck( cmd, cmd.tokens[i + 2] );
-			r1 = std::stoi( std::string( 1, cmd.tokens[i + 2][1] ) );
-			val |= r1 << 6;
-		} 
-		if ( opbit & 0x4C0D || fst == "JSR" )
+			val |= getRegister( cmd, args[0] ) << 9;
+			val |= getOffset( cmd, args[1], 9 );
+			break;
+		}
+		case REG_REG:
 		{
-			const int x = fst == "JSR" || opcode == BR ? 1 : 2;
-			target = checkSymbol( cmd.tokens[i + x] ) ? symbolTable.at( cmd.tokens[i + x] ) - start - cmd.n : convertNumber( cmd, cmd.tokens[i + x] );
-			const int len = fst == "JSR" ? 11 : 9;
-			checkOperand( cmd, target, len, true );			
-			target &= ( 1 << len ) - 1; 
-			target = fst == "JSR" ? target | 1 << 11 : target;
-			val |= target;
+			val |= getRegister( cmd, args[0] ) << 9;
+			val |= getRegister( cmd, args[1] ) << 6;
+			break;
 		}
-		if ( fst == "AND" || fst == "ADD" )
+		case REG_REG_ARG:
 		{
-			const bool imm = !checkRegister( cmd.tokens[i + 3] );
-			r2 = imm ? convertNumber( cmd, cmd.tokens[i + 3] ) : std::stoi( std::string( 1, cmd.tokens[i + 3][1] ) );	
-			if ( imm )
+			val |= getRegister( cmd, args[0] ) << 9;
+			val |= getRegister( cmd, args[1] ) << 6;
+			if ( checkRegister( args[2] ) )
 			{
-				checkOperand( cmd, r2, 5, true );
-				r2 &= 0x1F;
+				val |= args[2][1] - '0';
 			}
-			val |= r2;
-			val = imm ? val | 1 << 5 : val;
-		} 
-		else if ( fst == "LDR" || fst == "STR" )
-		{
-			int offset = convertNumber( cmd, cmd.tokens[i + 3] );
-			checkOperand( cmd, offset, 6, true );
-			offset &= 0x3F;
-			val |= offset;
-		} 
-		else if ( fst == "NOT" )
-		{
-			val |= 0x3F;
-		}
-		else if ( fst == "RET" )
-		{
-			val |= 7 << 6;
-		}
-		else if ( fst == "TRAP" )
-		{
-			const unsigned short tv = convertNumber( cmd, cmd.tokens[i + 1] );
-			checkOperand( cmd, tv, 8, false );
-			val |= tv;
+			else
+			{
+				const int imm = convertNumber( cmd, args[2] );
+				checkOperand( cmd, imm, 5, true );
+				val |= 1 << 5 | ( imm & 0x1F );
+			}
+			break;
 		}
-		else if ( opcode == BR )
+		case REG_REG_OFFSET6:
 		{
-			val |= getMask( fst );	
+			val |= getRegister( cmd, args[0] ) << 9;
+			val |= getRegister( cmd, args[1] ) << 6;
+			const int offset = convertNumber( cmd, args[2] );
+			checkOperand( cmd, offset, 6, true );
+			val |= offset & 0x3F;
+			break;
 		}
-		else if ( opcode == TRAP )
+		default:
 		{
-			val |= getVector( fst ); 
+			break;
 		}
-
-		toLittleEndian( val );
-		stream.write( reinterpret_cast<const char*>( &val ),  sizeof val );
 	}
+	toLittleEndian( val );
+	stream.write( reinterpret_cast<const char*>( &val ),  sizeof val );
 }
 
 int
-Assembler::getVector( const std::string& fst )
+Assembler::getOffset( const Command& cmd, const std::string_view arg, const int bits )
 {
-	if ( fst == "GETC" )
-	{
-		return 0x20;
-	} 
-	else if ( fst == "OUT" )
-	{
-		return 0x21;
-	}
-	else if ( fst == "PUTS" )
-	{
-		return 0x22;
-	}
-	else if ( fst == "IN" )
-	{
-		return 0x23;
-	}
-	else if ( fst == "PUTSP" )
-	{
-		return 0x24;
-	}
-	else
-	{
-		return 0x25;
-	}
-}
-
-int
-Assembler::getMask( const std::string& fst )
-{
-	if ( fst == "BR" || fst == "BRnzp" )
-	{
-		return BRnzp;
-	}
-	else if ( fst == "BRp" )
-	{
-		return BRp;
-	}
-	else if ( fst == "BRz" )
-	{
-		return BRz;
-	} 
-	else if ( fst == "BRn" )
-	{
-		return BRn;
-	}
-	else if ( fst == "BRzp" )
-	{
-		return BRzp;
-	}
-	else if ( fst == "BRnp" )
-	{
-		return BRnp;
-	} 
-	else
-	{
-		return BRnz;
-	}
-}
-
-int
-Assembler::getOpcode( const Command& cmd, const std::string& fst )
-{
-	if ( fst == "BR" || fst == "BRp" || fst == "BRz" || fst == "BRn"
-		|| fst == "BRzp" || fst == "BRnp" || fst == "BRnz" || fst == "BRnzp" )
-	{
-		return BR;
-	}
-	else if ( fst == "ADD" )
-	{
-		return ADD;
-	}
-	else if ( fst == "LD" )
-	{
-		return LD;
-	}
-	else if ( fst == "ST" )
-	{
-		return ST;
-	}
-	else if ( fst == "JSR" || fst == "JSRR" )
-	{
-		return JSR;
-	}
-	else if ( fst == "AND" )
-	{
-		return AND;
-	}
-	else if ( fst == "LDR" )
-	{
-		return LDR;
-	}
-	else if ( fst == "STR" )
-	{
-		return STR;
-	}
-	else if ( fst == "RTI" )
-	{
-		return RTI;
-	}
-	else if ( fst == "NOT" )
-	{
-		return NOT;
-	}
-	else if ( fst == "LDI" )
-	{
-		return LDI;
-	}
-	else if ( fst == "STI" )
-	{
-		return STI;
-	}
-	else if ( fst == "JMP" )
-	{
-		return JMP;
-	}
-	else if ( fst == "RES" )
-	{
-		return RES;
-	}
-	else if ( fst == "LEA" )
-	{
-		return LEA;
-	}
-	else if ( fst == "TRAP" || fst == "GETC" || fst == "OUT" || fst == "PUTS"
-		|| fst == "IN" || fst == "PUTSP" || fst == "HALT" )
-	{
-		return TRAP;
-	}
-	errorMessage( cmd, "Unknown Command: " + fst );
-	return 0;
+	const int* symbol = findSymbol( arg );
+	const int target = symbol ? *symbol - start - cmd.n : convertNumber( cmd, arg );
+	checkOperand( cmd, target, bits, true );
+	return target & ( ( 1 << bits ) - 1 );
 }
 
 void
 Assembler::handleDirectives( const Command& cmd, std::ofstream& stream )
 {
-	const std::string dir = cmd.isLabel ? cmd.tokens[1] : cmd.tokens[0];
-	if ( dir == ".ORIG" )
-	{
-		errorMessage( cmd, "More than one .ORIG in program" );
-	}
-	else if ( dir == ".FILL" )
+	const std::string_view dir = cmd.isLabel ? cmd.tokens[1] : cmd.tokens[0];
+	const Mnemonic* m = lookup( dir );
+	if ( !m || m->shape != DIRECTIVE )
 	{
-		unsigned short val = convertNumber( cmd, cmd.tokens[cmd.tokens.size() - 1] );
-		toLittleEndian( val );
-		stream.write( reinterpret_cast<const char*>( &val ),  sizeof val );
+		errorMessage( cmd, "Unknown directive: " + std::string( dir ) );
 	}
-	else if ( dir == ".BLKW" )
+	switch ( m->bits )
 	{
-		const unsigned short zero = 0;
-		for ( int i = 0; i < std::stoi( cmd.tokens[cmd.tokens.size() - 1] ); i++ )
+		case ORIG:
 		{
-			stream.write( reinterpret_cast<const char*>( &zero ), sizeof zero );
+			errorMessage( cmd, "More than one .ORIG in program" );
+			break;
 		}
-	}
-	else if ( dir == ".STRINGZ" )
-	{
-		const std::string str = cmd.tokens[cmd.tokens.size() - 1];
-		for ( std::string::size_type i = 0; i < str.size(); i++ )
+		case FILL:
 		{
-			unsigned short c = str[i];
-			if ( c == 92 && i+1 < str.length() && str[i+1] == 'n' )
+			unsigned short val = convertNumber( cmd, cmd.tokens[cmd.count - 1] );
+			toLittleEndian( val );
+			stream.write( reinterpret_cast<const char*>( &val ),  sizeof val );
+			break;
+		}
+		case BLKW:
+		{
+			const unsigned short zero = 0;
+			const int n = getCount( cmd );
+			for ( int i = 0; i < n; i++ )
 			{
-				c = 10;
-				i++;
+				stream.write( reinterpret_cast<const char*>( &zero ), sizeof zero );
 			}
-			toLittleEndian( c );
-			stream.write( reinterpret_cast<const char*>( &c ), sizeof c );
+			break;
+		}
+		case STRINGZ:
+		{
+			const std::string_view str = cmd.tokens[cmd.count - 1];
+			for ( size_t i = 0; i < str.size(); i++ )
+			{
+				unsigned short c = str[i];
+				if ( c == 92 && i+1 < str.length() && str[i+1] == 'n' )
+				{
+					c = 10;
+					i++;
+				}
+				toLittleEndian( c );
+				stream.write( reinterpret_cast<const char*>( &c ), sizeof c );
+			}
+			const unsigned short nt = '\0';
+			stream.write( reinterpret_cast<const char*>( &nt ), sizeof nt );	
+			break;
 		}
-		const unsigned short nt = '\0';
-		stream.write( reinterpret_cast<const char*>( &nt ), sizeof nt );	
-	}
-	else if ( dir != ".END" )
-	{
-		errorMessage( cmd, "Unknown directive: " + dir );
 	}
 }
 
@@ -527,18 +541,10 @@ Assembler::toLittleEndian( unsigned short& x )
 	x = x << 8 | x >> 8;
 }
 
-bool
-Assembler::checkSymbol( const std::string& symbol )
+const int*
+Assembler::findSymbol( const std::string_view symbol )
 {
-	try
-	{
-		symbolTable.at( symbol );
-		return true;
-	}
-	catch( const std::out_of_range& err )
-	{
-		return false;
-	}
+	return symbolTable.find( symbol );
 }
 
 void
@@ -552,31 +558,32 @@ Assembler::checkOperand( const Command& cmd, const int& operand, const int& bits
 }
 
 bool
-Assembler::checkRegister( const std::string& reg )
+Assembler::checkRegister( const std::string_view reg )
 {
-	return !( reg.length() != 2 || reg[0] != 'R' || std::stoi( std::string( 1, reg[1] ) ) > 7 );
+	return reg.length() == 2 && reg[0] == 'R' && reg[1] >= '0' && reg[1] <= '7';
 }
 
-void
-Assembler::registerCheck( const Command& cmd, const std::string& reg )
+int
+Assembler::getRegister( const Command& cmd, const std::string_view reg )
 {
 	if ( !checkRegister( reg ) )
 	{
-		errorMessage( cmd, "Invalid register: " + reg );
+		errorMessage( cmd, "Invalid register: " + std::string( reg ) );
 	}
+	return reg[1] - '0';
 }
 
 void
-Assembler::argumentsCheck( const Command& cmd, const std::string& fst, const int& length, const int& n )
+Assembler::argumentsCheck( const Command& cmd, const std::string_view fst, const int& length, const int& n )
 {
 	if ( length != n )
 	{
-		errorMessage( cmd, std::to_string( length ) + " arguments provided to " + fst + ", " + std::to_string( n ) + " arguments required" );
+		errorMessage( cmd, std::to_string( length ) + " arguments provided to " + std::string( fst ) + ", " + std::to_string( n ) + " arguments required" );
 	}
 }
 
 void
 Assembler::errorMessage( const Command& cmd, const std::string& err )
 {
-	throw std::runtime_error( "Error on line " + std::to_string( cmd.line ) + " : " + cmd.cmd + '\n' + err );
+	throw std::runtime_error( "Error on line " + std::to_string( cmd.line ) + " : " + std::string( cmd.cmd ) + '\n' + err );
 }
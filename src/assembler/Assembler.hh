@@ -1,7 +1,9 @@
 #include "Command.hh"
+#include "Source.hh"
+#include "SymbolTable.hh"
 #include <string>
+#include <string_view>
 #include <fstream>
-#include <map>
 #include <vector>
 
 class Assembler
@@ -12,27 +14,31 @@ class Assembler
 		void firstPass();
 		void secondPass();
 	private:
+		enum
+		{
+			NUMBER_SIZE = 64
+		};
 		const char* filename;
+		Source source;
 		int start;
 		std::vector<Command> tokens;
-		std::map<std::string, int> symbolTable;
-		std::istream& getCommand( std::istream& stream, std::string& str );
-		bool isNotWhiteSpace( const std::string& str );
-		void checkLiteral( const Command& cmd, const std::string& s );
+		std::vector<std::string_view> arena;
+		SymbolTable symbolTable;
+		bool parseNumber( const std::string_view s, const int base, long& val );
 		void checkOrig();
 		void checkEnd();
 		void buildTable();
-		int convertNumber( const Command& cmd, const std::string& str );
+		void writeSymbols( const std::string& outName );
+		int getCount( const Command& cmd );
+		int convertNumber( const Command& cmd, const std::string_view s );
 		void handleTokens( const Command& cmd, std::ofstream& stream );
 		void handleDirectives( const Command& cmd, std::ofstream& stream );
 		void toLittleEndian( unsigned short& val );
-		bool checkSymbol( const std::string& symbol );
-		int getOpcode( const Command& cmd, const std::string& fst );
-		int getVector( const std::string& fst );
-		int getMask( const std::string& fst );
+		const int* findSymbol( const std::string_view symbol );
+		int getOffset( const Command& cmd, const std::string_view arg, const int bits );
 		void checkOperand( const Command& cmd, const int& operand, const int& bits, const bool& isSigned );
-		bool checkRegister( const std::string& reg );
-		void registerCheck( const Command& cmd, const std::string& reg );
-		void argumentsCheck( const Command& cmd, const std::string& fst, const int& length, const int& n );
+		bool checkRegister( const std::string_view reg );
+		int getRegister( const Command& cmd, const std::string_view reg );
+		void argumentsCheck( const Command& cmd, const std::string_view fst, const int& length, const int& n );
 		void errorMessage( const Command& cmd, const std::string& err );
 };
@@ -1,56 +1,57 @@
 #include "Command.hh"
 
-Command::Command( const std::string str, int x, int y )
+Command::Command( const std::string_view str, int x, int y, const size_t start, const size_t length, const std::vector<std::string_view>& arena ) : line( x ), n( y ), cmd( str ), first( start ), count( length ), tokens( arena.data() + start )
 {
-	line = x;
-	n = y;
-	cmd = str;
-	tokens = toTokens( cmd );
 	isLabel = checkLabel( tokens[0] );
 	const int i = isLabel ? 1 : 0; 
 	isDirective = checkDirective( tokens[0 + i] );
 }
 
-std::vector<std::string>
-Command::toTokens( const std::string& str )
+void
+Command::toTokens( const std::string_view str, std::vector<std::string_view>& arena )
 {
-	std::vector<std::string> v;
-	std::string s;
+	size_t begin = 0;
+	size_t length = 0;
 	bool inString = false;
-	for ( const char& c : str )
+	for ( size_t i = 0; i < str.length(); i++ )
 	{
+		const char c = str[i];
 		if ( c == '\'' || c == '\"' )
 		{
+			if ( length == 0 )
+			{
+				begin = i + 1;
+			}
 			inString = !inString;
 		}
 		else if ( ( c != '\t' && c != ' ' && c != ',' ) || inString )
 		{
-			s.push_back( c );
-		}
-		else
-		{
-			if ( s.length() > 0 && !inString )
+			if ( length == 0 )
 			{
-				v.push_back( s );
-				s.clear();
+				begin = i;
 			}
+			length = i + 1 - begin;
+		}
+		else if ( length > 0 )
+		{
+			arena.push_back( str.substr( begin, length ) );
+			length = 0;
 		}
 	}
-	if ( s.length() > 0 && !inString )
+	if ( length > 0 && !inString )
 	{
-		v.push_back( s );
+		arena.push_back( str.substr( begin, length ) );
 	}
-	return v;
 }
 
 bool
-Command::checkLabel( const std::string& fst )
+Command::checkLabel( const std::string_view fst )
 {
 	return fst[fst.length() - 1] == ':';
 }
 
 bool
-Command::checkDirective( const std::string& fst )
+Command::checkDirective( const std::string_view fst )
 {
 	return fst[0] == '.';
 }
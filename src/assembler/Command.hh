@@ -1,18 +1,20 @@
-#include <string>
+#include <string_view>
 #include <vector>
 
 class Command
 {
 	public:
-		Command( const std::string line, int x, int y );
+		Command( const std::string_view str, int x, int y, const size_t start, const size_t length, const std::vector<std::string_view>& arena );
 		int line;
 		int n;
-		std::string cmd;
-		std::vector<std::string> tokens;
+		std::string_view cmd;
+		size_t first;
+		size_t count;
+		const std::string_view* tokens;
 		bool isLabel;
 		bool isDirective;
+		static void toTokens( const std::string_view str, std::vector<std::string_view>& arena );
 	private:
-		std::vector<std::string> toTokens( const std::string& str );
-		bool checkLabel( const std::string& fst );
-		bool checkDirective( const std::string& fst );
+		bool checkLabel( const std::string_view fst );
+		bool checkDirective( const std::string_view fst );
 };
@@ -0,0 +1,66 @@
+#include "Source.hh"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#define WINDOWS __CYGWIN__ || _WIN32
+
+#if !( WINDOWS )
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
+
+Source::Source( const char* filePath ) : data( NULL ), size( 0 ), mapped( false )
+{
+#if !( WINDOWS )
+	const int fd = open( filePath, O_RDONLY );
+	struct stat st;
+	if ( fd >= 0 && fstat( fd, &st ) == 0 && st.st_size > 0 )
+	{
+		void* p = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( p != MAP_FAILED )
+		{
+			data = static_cast<const char*>( p );
+			size = st.st_size;
+			mapped = true;
+		}
+	}
+	if ( fd >= 0 )
+	{
+		close( fd );
+	}
+	if ( mapped )
+	{
+		return;
+	}
+#endif
+	std::ifstream f( filePath, std::ios::binary );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + std::string( filePath ) );
+	}
+	buffer.assign( std::istreambuf_iterator<char>( f ), std::istreambuf_iterator<char>() );
+	data = buffer.data();
+	size = buffer.size();
+}
+
+Source::~Source()
+{
+#if !( WINDOWS )
+	if ( mapped )
+	{
+		munmap( const_cast<char*>( data ), size );
+	}
+#endif
+}
+
+std::string_view
+Source::getText()
+{
+	return std::string_view( data, size );
+}
@@ -0,0 +1,21 @@
+#ifndef SOURCE_HH
+#define SOURCE_HH
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+class Source
+{
+	public:
+		Source( const char* filePath );
+		~Source();
+		std::string_view getText();
+	private:
+		const char* data;
+		size_t size;
+		bool mapped;
+		std::vector<char> buffer;
+};
+
+#endif
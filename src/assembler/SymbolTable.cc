@@ -0,0 +1,85 @@
+#include "SymbolTable.hh"
+#include <algorithm>
+
+SymbolTable::SymbolTable() : slots( INITIAL_SIZE ), count( 0 ) { }
+
+size_t
+SymbolTable::hash( std::string_view name )
+{
+	size_t h = 14695981039346656037ULL;
+	for ( const char c : name )
+	{
+		h = ( h ^ static_cast<unsigned char>( c ) ) * 1099511628211ULL;
+	}
+	return h;
+}
+
+size_t
+SymbolTable::probe( std::string_view name, const size_t h ) const
+{
+	const size_t mask = slots.size() - 1;
+	size_t i = h & mask;
+	while ( slots[i].used && ( slots[i].hash != h || slots[i].name != name ) )
+	{
+		i = ( i + 1 ) & mask;
+	}
+	return i;
+}
+
+void
+SymbolTable::grow()
+{
+	std::vector<Slot> old( slots.size() * 2 );
+	old.swap( slots );
+	for ( Slot& s : old )
+	{
+		if ( s.used )
+		{
+			slots[probe( s.name, s.hash )] = std::move( s );
+		}
+	}
+}
+
+bool
+SymbolTable::insert( std::string_view name, const int addr )
+{
+	if ( ( count + 1 ) * 2 > slots.size() )
+	{
+		grow();
+	}
+	const size_t h = hash( name );
+	Slot& s = slots[probe( name, h )];
+	if ( s.used )
+	{
+		return false;
+	}
+	s.name = name;
+	s.hash = h;
+	s.addr = addr;
+	s.used = true;
+	count++;
+	return true;
+}
+
+const int*
+SymbolTable::find( std::string_view name ) const
+{
+	const Slot& s = slots[probe( name, hash( name ) )];
+	return s.used ? &s.addr : NULL;
+}
+
+std::vector<std::pair<std::string, int>>
+SymbolTable::sorted() const
+{
+	std::vector<std::pair<std::string, int>> v;
+	v.reserve( count );
+	for ( const Slot& s : slots )
+	{
+		if ( s.used )
+		{
+			v.emplace_back( s.name, s.addr );
+		}
+	}
+	std::sort( v.begin(), v.end() );
+	return v;
+}
@@ -0,0 +1,36 @@
+#ifndef SYMBOL_TABLE_HH
+#define SYMBOL_TABLE_HH
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class SymbolTable
+{
+	public:
+		SymbolTable();
+		bool insert( std::string_view name, const int addr );
+		const int* find( std::string_view name ) const;
+		std::vector<std::pair<std::string, int>> sorted() const;
+	private:
+		enum
+		{
+			INITIAL_SIZE = 64
+		};
+		struct Slot
+		{
+			std::string name;
+			size_t hash;
+			int addr;
+			bool used;
+		};
+		std::vector<Slot> slots;
+		size_t count;
+		static size_t hash( std::string_view name );
+		size_t probe( std::string_view name, const size_t h ) const;
+		void grow();
+};
+
+#endif
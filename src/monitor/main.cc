@@ -0,0 +1,87 @@
+#include "../vm/Monitor.hh"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static const char* const opcodeNames[] =
+{
+	"BR", "ADD", "LD", "ST", "JSR", "AND", "LDR", "STR",
+	"RTI", "NOT", "LDI", "STI", "JMP", "RES", "LEA", "TRAP"
+};
+
+static const char* const stateNames[] =
+{
+	"starting", "running", "halted", "stopped"
+};
+
+int usage()
+{
+	std::cerr << "usage: ./main [-i interval] name\n"
+		<< "       name: shared memory name given to the virtual machine with -m\n"
+		<< "       interval: milliseconds between samples, 1000 by default\n";
+	return 1;
+}
+
+static void
+printCounts( const Monitor::Counters& c )
+{
+	std::cout << "opcodes:";
+	for ( int i = 0; i < 16; i++ )
+	{
+		const unsigned long long count = c.opcodes[i].load( std::memory_order_relaxed );
+		if ( count )
+		{
+			std::cout << ' ' << opcodeNames[i] << '=' << count;
+		}
+	}
+	std::cout << "\ntraps:";
+	for ( int i = 0; i < 256; i++ )
+	{
+		const unsigned long long count = c.traps[i].load( std::memory_order_relaxed );
+		if ( count )
+		{
+			std::cout << " x" << std::hex << std::uppercase << i << std::dec << '=' << count;
+		}
+	}
+	std::cout << '\n';
+}
+
+int main( int argc, char* argv[] )
+{
+	unsigned long interval = 1000;
+	int i = 1;
+	if ( i + 1 < argc && std::string( argv[i] ) == "-i" )
+	{
+		interval = std::stoul( argv[i + 1] );
+		i += 2;
+	}
+	if ( i + 1 != argc || !interval )
+	{
+		return usage();
+	}
+	Monitor monitor( argv[i], false );
+	const Monitor::Counters& c = monitor.get();
+	unsigned long long last = c.instret.load( std::memory_order_relaxed );
+	while ( true )
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds( interval ) );
+		const unsigned int state = c.state.load( std::memory_order_acquire );
+		const unsigned long long instret = c.instret.load( std::memory_order_relaxed );
+		const bool running = state <= Monitor::RUNNING && monitor.isAlive();
+		std::cout << ( state <= Monitor::STOPPED ? stateNames[state] : "unknown" )
+			<< ( running || state > Monitor::RUNNING ? "" : " (exited)" )
+			<< "\tpc x" << std::hex << std::uppercase << std::setfill( '0' ) << std::setw( 4 ) << c.pc.load( std::memory_order_relaxed ) << std::dec
+			<< "\tinstructions " << instret
+			<< "\trate " << ( instret - last ) * 1000 / interval << "/s"
+			<< "\tpolls " << c.kbsrPolls.load( std::memory_order_relaxed )
+			<< "\tbytes " << c.bytesOutput.load( std::memory_order_relaxed ) << std::endl;
+		last = instret;
+		if ( !running )
+		{
+			printCounts( c );
+			return 0;
+		}
+	}
+}
@@ -0,0 +1,399 @@
+#include "Recompiler.hh"
+#include "../vm/CPU.hh"
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+enum
+{
+	KBSR = 0xFE00,
+	PC_START = 0x3000,
+	HALT = 0x25
+};
+
+enum Opcode
+{
+	BR,
+	ADD,
+	LD,
+	ST,
+	JSR,
+	AND,
+	LDR,
+	STR,
+	RTI,
+	NOT,
+	LDI,
+	STI,
+	JMP,
+	RES,
+	LEA,
+	TRAP
+};
+
+static short
+sext( const unsigned short val, const int len )
+{
+	return static_cast<short>( val << ( 16 - len ) ) >> ( 16 - len );
+}
+
+Recompiler::Recompiler( const std::vector<std::string>& paths ) : mem( MEM_SIZE ), loaded( MEM_SIZE ), reached( MEM_SIZE ), leader( MEM_SIZE ), usesMemory( false )
+{
+	for ( const std::string& path : paths )
+	{
+		images.emplace_back( new Image( path ) );
+		const Image& image = *images.back();
+		if ( image.getOrigin() + image.getSize() > MEM_SIZE )
+		{
+			throw std::runtime_error( path + " runs past the end of memory" );
+		}
+		image.copyTo( mem.data() );
+		for ( size_t i = 0; i < image.getSize(); i++ )
+		{
+			loaded[image.getOrigin() + i] = true;
+		}
+	}
+	explore( PC_START );
+	if ( !reached[PC_START] )
+	{
+		throw std::runtime_error( "No code at x3000" );
+	}
+}
+
+void
+Recompiler::explore( const unsigned short entry )
+{
+	std::vector<unsigned short> pending( 1, entry );
+	leader[entry] = true;
+	while ( !pending.empty() )
+	{
+		unsigned int addr = pending.back();
+		pending.pop_back();
+		while ( addr < KBSR && loaded[addr] && !reached[addr] )
+		{
+			reached[addr] = true;
+			const unsigned short instr = mem[addr];
+			const unsigned short next = addr + 1;
+			bool stop = false;
+			switch ( instr >> 12 )
+			{
+				case BR:
+				{
+					if ( instr & 0x0E00 )
+					{
+						const unsigned short target = next + sext( instr & 0x1FF, 9 );
+						leader[target] = true;
+						pending.push_back( target );
+					}
+					stop = ( instr & 0x0E00 ) == 0x0E00;
+					break;
+				}
+				case JSR:
+				{
+					if ( instr & 0x0800 )
+					{
+						const unsigned short target = next + sext( instr & 0x7FF, 11 );
+						leader[target] = true;
+						pending.push_back( target );
+					}
+					leader[next] = true;
+					break;
+				}
+				case TRAP:
+				{
+					leader[next] = true;
+					stop = ( instr & 0xFF ) == HALT;
+					break;
+				}
+				case RTI:
+				case JMP:
+				case RES:
+				{
+					stop = true;
+					break;
+				}
+			}
+			if ( stop )
+			{
+				break;
+			}
+			addr = next;
+		}
+	}
+}
+
+bool
+Recompiler::isCompiled( const unsigned int addr )
+{
+	return addr < MEM_SIZE && reached[addr];
+}
+
+bool
+Recompiler::ends( const unsigned short instr )
+{
+	switch ( instr >> 12 )
+	{
+		case BR:
+		{
+			return ( instr & 0x0E00 ) == 0x0E00;
+		}
+		case JSR:
+		case RTI:
+		case JMP:
+		case RES:
+		case TRAP:
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string
+Recompiler::hex( const unsigned short val )
+{
+	char s[8];
+	std::snprintf( s, sizeof( s ), "0x%04X", val );
+	return s;
+}
+
+std::string
+Recompiler::label( const unsigned short addr )
+{
+	return "x" + hex( addr ).substr( 2 );
+}
+
+std::string
+Recompiler::offset( const int reg, const short off )
+{
+	const std::string base = "R[" + std::to_string( reg ) + "]";
+	return off == 0 ? base : off < 0 ? base + " - " + std::to_string( -off ) : base + " + " + std::to_string( off );
+}
+
+std::string
+Recompiler::read( const unsigned short addr )
+{
+	if ( addr < KBSR )
+	{
+		usesMemory = true;
+		return "M[" + hex( addr ) + "]";
+	}
+	return "vm.read( " + hex( addr ) + " )";
+}
+
+void
+Recompiler::writeJump( std::ostream& out, const unsigned short target, const std::string& indent )
+{
+	if ( isCompiled( target ) )
+	{
+		out << indent << "goto " << label( target ) << ";\n";
+	}
+	else
+	{
+		out << indent << "PC = " << hex( target ) << ";\n" << indent << "goto dispatch;\n";
+	}
+}
+
+void
+Recompiler::writeStore( std::ostream& out, const std::string& addr, const int reg, const unsigned short next )
+{
+	out << "\tif ( vm.write( " << addr << ", R[" << reg << "] ) )\n\t{\n\t\tPC = " << hex( next ) << ";\n\t\tgoto dispatch;\n\t}\n";
+}
+
+void
+Recompiler::writeInstr( std::ostream& out, const unsigned short addr )
+{
+	const unsigned short instr = mem[addr];
+	const unsigned short next = addr + 1;
+	const int r0 = ( instr >> 9 ) & 0x7;
+	const int r1 = ( instr >> 6 ) & 0x7;
+	const std::string dst = "R[" + std::to_string( r0 ) + "]";
+	const std::string setcc = "\tvm.setcc( " + dst + " );\n";
+	switch ( instr >> 12 )
+	{
+		case BR:
+		{
+			if ( ( instr & 0x0E00 ) == 0x0E00 )
+			{
+				writeJump( out, next + sext( instr & 0x1FF, 9 ), "\t" );
+			}
+			else if ( instr & 0x0E00 )
+			{
+				out << "\tif ( vm.test( " << r0 << " ) )\n\t{\n";
+				writeJump( out, next + sext( instr & 0x1FF, 9 ), "\t\t" );
+				out << "\t}\n";
+			}
+			break;
+		}
+		case ADD:
+		case AND:
+		{
+			const char* op = instr >> 12 == ADD ? " + " : " & ";
+			if ( !( instr & 0x20 ) )
+			{
+				out << '\t' << dst << " = R[" << r1 << "]" << op << "R[" << ( instr & 0x7 ) << "];\n";
+			}
+			else if ( instr >> 12 == ADD )
+			{
+				out << '\t' << dst << " = " << offset( r1, sext( instr & 0x1F, 5 ) ) << ";\n";
+			}
+			else
+			{
+				out << '\t' << dst << " = R[" << r1 << "]" << op << hex( sext( instr & 0x1F, 5 ) ) << ";\n";
+			}
+			out << setcc;
+			break;
+		}
+		case NOT:
+		{
+			out << '\t' << dst << " = ~R[" << r1 << "];\n" << setcc;
+			break;
+		}
+		case LEA:
+		{
+			out << '\t' << dst << " = " << hex( next + sext( instr & 0x1FF, 9 ) ) << ";\n" << setcc;
+			break;
+		}
+		case LD:
+		{
+			out << '\t' << dst << " = " << read( next + sext( instr & 0x1FF, 9 ) ) << ";\n" << setcc;
+			break;
+		}
+		case LDI:
+		{
+			out << '\t' << dst << " = vm.read( " << read( next + sext( instr & 0x1FF, 9 ) ) << " );\n" << setcc;
+			break;
+		}
+		case LDR:
+		{
+			out << '\t' << dst << " = vm.read( " << offset( r1, sext( instr & 0x3F, 6 ) ) << " );\n" << setcc;
+			break;
+		}
+		case ST:
+		{
+			writeStore( out, hex( next + sext( instr & 0x1FF, 9 ) ), r0, next );
+			break;
+		}
+		case STI:
+		{
+			writeStore( out, read( next + sext( instr & 0x1FF, 9 ) ), r0, next );
+			break;
+		}
+		case STR:
+		{
+			writeStore( out, offset( r1, sext( instr & 0x3F, 6 ) ), r0, next );
+			break;
+		}
+		case JSR:
+		{
+			out << "\tR[7] = " << hex( next ) << ";\n";
+			if ( instr & 0x0800 )
+			{
+				writeJump( out, next + sext( instr & 0x7FF, 11 ), "\t" );
+			}
+			else
+			{
+				out << "\tPC = R[" << r1 << "];\n\tgoto dispatch;\n";
+			}
+			break;
+		}
+		case JMP:
+		{
+			out << "\tPC = R[" << r1 << "];\n\tgoto dispatch;\n";
+			break;
+		}
+		case TRAP:
+		{
+			out << "\tPC = vm.trap( " << hex( next ) << ", " << hex( instr & 0xFF ) << " );\n\tgoto dispatch;\n";
+			break;
+		}
+		default:
+		{
+			out << "\tPC = vm.interpret( " << hex( addr ) << " );\n\tgoto dispatch;\n";
+			break;
+		}
+	}
+}
+
+void
+Recompiler::writeImage( std::ostream& out, const size_t index )
+{
+	const Image& image = *images[index];
+	out << "static const unsigned char image" << index << "[] =\n{";
+	for ( size_t i = 0; i <= image.getSize(); i++ )
+	{
+		const unsigned short word = i ? mem[image.getOrigin() + i - 1] : image.getOrigin();
+		char s[16];
+		std::snprintf( s, sizeof( s ), "0x%02X, 0x%02X,", word >> 8, word & 0xFF );
+		out << ( i % 8 ? " " : "\n\t" ) << s;
+	}
+	out << "\n};\n\n";
+}
+
+void
+Recompiler::write( std::ostream& out )
+{
+	std::ostringstream blocks, cases, body;
+	size_t blockCount = 0;
+	for ( unsigned int addr = 0; addr < MEM_SIZE; addr++ )
+	{
+		if ( !reached[addr] )
+		{
+			continue;
+		}
+		const unsigned int start = addr;
+		body << label( start ) << ":\n";
+		cases << "\t\tcase " << hex( start ) << ": goto " << label( start ) << ";\n";
+		while ( true )
+		{
+			writeInstr( body, addr );
+			if ( ends( mem[addr] ) )
+			{
+				break;
+			}
+			if ( !isCompiled( addr + 1 ) )
+			{
+				writeJump( body, addr + 1, "\t" );
+				break;
+			}
+			if ( leader[addr + 1] )
+			{
+				break;
+			}
+			addr++;
+		}
+		blocks << "\t{ " << hex( start ) << ", " << hex( addr + 1 ) << " },\n";
+		blockCount++;
+	}
+
+	out << "#include \"Native.hh\"\n\n";
+	for ( size_t i = 0; i < images.size(); i++ )
+	{
+		writeImage( out, i );
+	}
+	out << "static const Native::Segment segments[] =\n{\n";
+	for ( size_t i = 0; i < images.size(); i++ )
+	{
+		std::string name;
+		for ( const char c : images[i]->getPath() )
+		{
+			name += c == '\\' || c == '"' ? std::string( "\\" ) + c : std::string( 1, c );
+		}
+		out << "\t{ \"" << name << "\", image" << i << ", sizeof( image" << i << " ) },\n";
+	}
+	out << "};\n\n";
+	out << "static const unsigned short blocks[][2] =\n{\n" << blocks.str() << "};\n\n";
+	out << "static void\nrun( Native& vm )\n{\n";
+	out << "\tunsigned short* R = vm.registers();\n";
+	if ( usesMemory )
+	{
+		out << "\tunsigned short* M = vm.memory();\n";
+	}
+	out << "\tunsigned short PC = vm.getPC();\n";
+	out << "dispatch:\n\tif ( vm.isStopped() )\n\t{\n\t\tvm.setPC( PC );\n\t\treturn;\n\t}\n";
+	out << "\tswitch ( PC )\n\t{\n" << cases.str() << "\t}\n";
+	out << "\tPC = vm.interpret( PC );\n\tgoto dispatch;\n";
+	out << body.str() << "}\n\n";
+	out << "static const Native::Program program = { segments, " << images.size() << ", blocks, " << blockCount << ", run };\n\n";
+	out << "int main()\n{\n\treturn Native::main( program );\n}\n";
+}
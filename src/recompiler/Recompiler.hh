@@ -0,0 +1,33 @@
+#ifndef RECOMPILER_HH
+#define RECOMPILER_HH
+
+#include "../vm/Image.hh"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Recompiler
+{
+	public:
+		Recompiler( const std::vector<std::string>& paths );
+		void write( std::ostream& out );
+	private:
+		std::vector<std::unique_ptr<Image>> images;
+		std::vector<unsigned short> mem;
+		std::vector<bool> loaded, reached, leader;
+		bool usesMemory;
+		void explore( const unsigned short entry );
+		bool isCompiled( const unsigned int addr );
+		bool ends( const unsigned short instr );
+		std::string label( const unsigned short addr );
+		std::string hex( const unsigned short val );
+		std::string offset( const int reg, const short off );
+		std::string read( const unsigned short addr );
+		void writeJump( std::ostream& out, const unsigned short target, const std::string& indent );
+		void writeStore( std::ostream& out, const std::string& addr, const int reg, const unsigned short next );
+		void writeImage( std::ostream& out, const size_t index );
+		void writeInstr( std::ostream& out, const unsigned short addr );
+};
+
+#endif
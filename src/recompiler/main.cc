@@ -0,0 +1,42 @@
+#include "Recompiler.hh"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int usage()
+{
+	std::cerr << "usage: ./main [-o out] bin1 [bin2 ...]\n"
+		<< "       bin1, bin2, etc.: path to an assembled LC-3 program, loaded together and run from x3000\n"
+		<< "       out: C++ file to write, bin1 with a .cc extension by default\n";
+	return 1;
+}
+
+int main( int argc, char* argv[] )
+{
+	std::string out;
+	int i = 1;
+	if ( i + 1 < argc && std::string( argv[i] ) == "-o" )
+	{
+		out = argv[i + 1];
+		i += 2;
+	}
+	if ( i == argc )
+	{
+		return usage();
+	}
+	const std::vector<std::string> images( argv + i, argv + argc );
+	if ( out.empty() )
+	{
+		out = images[0].substr( 0, images[0].rfind( '.' ) ) + ".cc";
+	}
+	Recompiler recompiler( images );
+	std::ofstream f( out );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + out );
+	}
+	recompiler.write( f );
+	return 0;
+}
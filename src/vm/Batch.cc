@@ -0,0 +1,345 @@
+#include "Batch.hh"
+#include "Input.hh"
+#include "Console.hh"
+#include "Lockstep.hh"
+#include "Scheduler.hh"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+Batch::Batch( const Engine e, const unsigned long long max, const unsigned int threads, const unsigned long long slice )
+	: engine( e ), limit( max ), quantum( slice ), workers( threads > 0 ? threads : 1 ) { }
+
+int
+Batch::run( const char* manifest, const char* outDir )
+{
+	dir = outDir;
+	readManifest( manifest );
+	results.assign( jobs.size(), Result() );
+
+	std::vector<Queue> initial( workers );
+	queues.swap( initial );
+	if ( engine == LOCKSTEP_ENGINE && !quantum )
+	{
+		group();
+	}
+	const size_t tasks = groups.empty() ? jobs.size() : groups.size();
+	for ( size_t i = 0; i < tasks; i++ )
+	{
+		queues[i % workers].jobs.push_back( i );
+	}
+
+	std::vector<std::thread> threads;
+	for ( unsigned int i = 1; i < workers; i++ )
+	{
+		threads.emplace_back( &Batch::work, this, i );
+	}
+	work( 0 );
+	for ( std::thread& t : threads )
+	{
+		t.join();
+	}
+
+	writeResults();
+	int failed = 0;
+	for ( const Result& r : results )
+	{
+		failed += r.status != "halted";
+	}
+	std::cerr << jobs.size() << " runs, " << jobs.size() - failed << " halted, " << failed << " did not halt\n";
+	return failed ? 1 : 0;
+}
+
+void
+Batch::readManifest( const char* manifest )
+{
+	std::ifstream f( manifest );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + std::string( manifest ) );
+	}
+	std::string line;
+	while ( std::getline( f, line ) )
+	{
+		std::istringstream tokens( line );
+		Job job;
+		if ( !( tokens >> job.input ) || job.input[0] == '#' )
+		{
+			continue;
+		}
+		std::string image;
+		while ( tokens >> image )
+		{
+			job.images.push_back( image );
+		}
+		if ( job.images.empty() )
+		{
+			throw std::runtime_error( "No image given for run " + std::to_string( jobs.size() ) + ": " + line );
+		}
+		jobs.push_back( job );
+	}
+}
+
+void
+Batch::work( const size_t self )
+{
+	if ( quantum )
+	{
+		schedule( self );
+		return;
+	}
+	size_t job;
+	while ( take( self, job ) )
+	{
+		if ( groups.empty() )
+		{
+			execute( job );
+		}
+		else
+		{
+			executeGroup( job );
+		}
+	}
+}
+
+bool
+Batch::take( const size_t self, size_t& job )
+{
+	{
+		std::lock_guard<std::mutex> guard( queues[self].lock );
+		if ( !queues[self].jobs.empty() )
+		{
+			job = queues[self].jobs.back();
+			queues[self].jobs.pop_back();
+			return true;
+		}
+	}
+	for ( size_t i = 1; i < workers; i++ )
+	{
+		Queue& victim = queues[( self + i ) % workers];
+		std::lock_guard<std::mutex> guard( victim.lock );
+		if ( !victim.jobs.empty() )
+		{
+			job = victim.jobs.front();
+			victim.jobs.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void
+Batch::execute( const size_t job )
+{
+	Result& result = results[job];
+	const std::string outPath = dir + "/" + std::to_string( job ) + ".out";
+	std::FILE* out = std::fopen( outPath.c_str(), "wb" );
+	if ( !out )
+	{
+		result.status = "error: can not open " + outPath;
+		return;
+	}
+	{
+		Console console( out, false );
+		try
+		{
+			StringInput input( jobs[job].input == "-" ? std::string() : readFile( jobs[job].input ) );
+			std::unique_ptr<CPU> cpu( new CPU( input, console ) );
+			try
+			{
+				load( *cpu, job );
+				cpu->run( engine, limit );
+				result.status = cpu->isHalted() ? "halted" : "limit";
+			}
+			catch ( const std::exception& err )
+			{
+				result.status = std::string( "error: " ) + err.what();
+			}
+			result.instructions = cpu->getInstructionCount();
+		}
+		catch ( const std::exception& err )
+		{
+			result.status = std::string( "error: " ) + err.what();
+		}
+	}
+	std::fclose( out );
+}
+
+void
+Batch::schedule( const size_t self )
+{
+	struct Run
+	{
+		size_t job;
+		std::FILE* out;
+		std::unique_ptr<Console> console;
+		std::unique_ptr<StringInput> input;
+		std::unique_ptr<CPU> cpu;
+		size_t task;
+	};
+	Scheduler scheduler( engine, quantum, limit );
+	std::vector<Run> runs;
+	for ( const size_t job : queues[self].jobs )
+	{
+		Result& result = results[job];
+		const std::string outPath = dir + "/" + std::to_string( job ) + ".out";
+		Run run = { job, std::fopen( outPath.c_str(), "wb" ), NULL, NULL, NULL, 0 };
+		if ( !run.out )
+		{
+			result.status = "error: can not open " + outPath;
+			continue;
+		}
+		try
+		{
+			run.console.reset( new Console( run.out, false ) );
+			run.input.reset( new StringInput( jobs[job].input == "-" ? std::string() : readFile( jobs[job].input ) ) );
+			run.cpu.reset( new CPU( *run.input, *run.console ) );
+			load( *run.cpu, job );
+			run.task = scheduler.add( *run.cpu );
+		}
+		catch ( const std::exception& err )
+		{
+			result.status = std::string( "error: " ) + err.what();
+			run.cpu.reset();
+		}
+		runs.push_back( std::move( run ) );
+	}
+
+	scheduler.run();
+
+	for ( Run& run : runs )
+	{
+		Result& result = results[run.job];
+		if ( run.cpu )
+		{
+			const std::string& error = scheduler.getError( run.task );
+			result.status = !error.empty() ? "error: " + error : run.cpu->isHalted() ? "halted" : "limit";
+			result.instructions = run.cpu->getInstructionCount();
+		}
+		run.cpu.reset();
+		run.console.reset();
+		std::fclose( run.out );
+	}
+}
+
+void
+Batch::group()
+{
+	std::map<std::vector<std::string>, size_t> last;
+	for ( size_t job = 0; job < jobs.size(); job++ )
+	{
+		auto found = last.find( jobs[job].images );
+		if ( found == last.end() || groups[found->second].size() == Lockstep::LANES )
+		{
+			found = last.insert_or_assign( jobs[job].images, groups.size() ).first;
+			groups.emplace_back();
+		}
+		groups[found->second].push_back( job );
+	}
+}
+
+void
+Batch::executeGroup( const size_t group )
+{
+	struct Run
+	{
+		size_t job;
+		std::FILE* out;
+		std::unique_ptr<Console> console;
+		std::unique_ptr<StringInput> input;
+		std::unique_ptr<CPU> cpu;
+		size_t lane;
+	};
+	Lockstep lockstep;
+	std::vector<Run> runs;
+	for ( const size_t job : groups[group] )
+	{
+		Result& result = results[job];
+		const std::string outPath = dir + "/" + std::to_string( job ) + ".out";
+		Run run = { job, std::fopen( outPath.c_str(), "wb" ), NULL, NULL, NULL, 0 };
+		if ( !run.out )
+		{
+			result.status = "error: can not open " + outPath;
+			continue;
+		}
+		try
+		{
+			run.console.reset( new Console( run.out, false ) );
+			run.input.reset( new StringInput( jobs[job].input == "-" ? std::string() : readFile( jobs[job].input ) ) );
+			run.cpu.reset( new CPU( *run.input, *run.console ) );
+			load( *run.cpu, job );
+			run.lane = lockstep.add( *run.cpu );
+		}
+		catch ( const std::exception& err )
+		{
+			result.status = std::string( "error: " ) + err.what();
+			run.cpu.reset();
+		}
+		runs.push_back( std::move( run ) );
+	}
+
+	lockstep.run( limit );
+
+	for ( Run& run : runs )
+	{
+		Result& result = results[run.job];
+		if ( run.cpu )
+		{
+			const std::string& error = lockstep.getError( run.lane );
+			result.status = !error.empty() ? "error: " + error : run.cpu->isHalted() ? "halted" : "limit";
+			result.instructions = run.cpu->getInstructionCount();
+		}
+		run.cpu.reset();
+		run.console.reset();
+		std::fclose( run.out );
+	}
+}
+
+void
+Batch::load( CPU& cpu, const size_t job )
+{
+	std::vector<const Image*> images;
+	for ( const std::string& path : jobs[job].images )
+	{
+		images.push_back( &cache.get( path ) );
+	}
+	cpu.loadImages( images );
+}
+
+std::string
+Batch::readFile( const std::string& path )
+{
+	std::ifstream f( path, std::ios::binary );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + path );
+	}
+	std::ostringstream contents;
+	contents << f.rdbuf();
+	return contents.str();
+}
+
+void
+Batch::writeResults()
+{
+	const std::string path = dir + "/results.tsv";
+	std::ofstream f( path );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + path );
+	}
+	f << "run\tstatus\tinstructions\tinput\timages\n";
+	for ( size_t i = 0; i < jobs.size(); i++ )
+	{
+		f << i << '\t' << results[i].status << '\t' << results[i].instructions << '\t' << jobs[i].input << '\t';
+		for ( size_t j = 0; j < jobs[i].images.size(); j++ )
+		{
+			f << ( j ? " " : "" ) << jobs[i].images[j];
+		}
+		f << '\n';
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef BATCH_HH
+#define BATCH_HH
+
+#include "CPU.hh"
+#include "Image.hh"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Batch
+{
+	public:
+		Batch( const Engine e, const unsigned long long max, const unsigned int threads, const unsigned long long slice );
+		int run( const char* manifest, const char* outDir );
+	private:
+		struct Job
+		{
+			std::string input;
+			std::vector<std::string> images;
+		};
+		struct Result
+		{
+			std::string status;
+			unsigned long long instructions;
+		};
+		struct Queue
+		{
+			std::mutex lock;
+			std::deque<size_t> jobs;
+		};
+		Engine engine;
+		unsigned long long limit, quantum;
+		unsigned int workers;
+		std::string dir;
+		std::vector<Job> jobs;
+		std::vector<Result> results;
+		std::vector<Queue> queues;
+		std::vector<std::vector<size_t>> groups;
+		ImageCache cache;
+		void readManifest( const char* manifest );
+		void work( const size_t self );
+		bool take( const size_t self, size_t& job );
+		void execute( const size_t job );
+		void schedule( const size_t self );
+		void group();
+		void executeGroup( const size_t group );
+		std::string readFile( const std::string& path );
+		void load( CPU& cpu, const size_t job );
+		void writeResults();
+};
+
+#endif
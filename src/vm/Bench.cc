@@ -0,0 +1,133 @@
+#include "Bench.hh"
+#include "Input.hh"
+#include "Console.hh"
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+static const char* const engineNames[] =
+{
+	"switch", "threaded", "jit", "lockstep"
+};
+
+Bench::Bench( const Engine e, const unsigned int repeats ) : engine( e ), runs( repeats > 0 ? repeats : 1 ) { }
+
+int
+Bench::run( const char* suite, std::ostream& out )
+{
+	readSuite( suite );
+	out << "workload\tengine\truns\tinstructions\tmean_seconds\tstddev_seconds\tmin_seconds\tmips\tcv_percent\n";
+	int failed = 0;
+	for ( const Workload& w : workloads )
+	{
+		failed += !measure( w, out );
+	}
+	return failed ? 1 : 0;
+}
+
+void
+Bench::readSuite( const char* suite )
+{
+	std::ifstream f( suite );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + std::string( suite ) );
+	}
+	std::string line;
+	while ( std::getline( f, line ) )
+	{
+		std::istringstream tokens( line );
+		Workload w;
+		std::string limit;
+		if ( !( tokens >> w.name ) || w.name[0] == '#' )
+		{
+			continue;
+		}
+		std::string image;
+		if ( !( tokens >> limit >> w.input >> image ) )
+		{
+			throw std::runtime_error( "Incomplete workload: " + line );
+		}
+		w.limit = limit == "-" ? ULLONG_MAX : std::stoull( limit );
+		do
+		{
+			w.images.push_back( image );
+		}
+		while ( tokens >> image );
+		workloads.push_back( w );
+	}
+}
+
+bool
+Bench::measure( const Workload& w, std::ostream& out )
+{
+	const std::string input = w.input == "-" ? std::string() : readFile( w.input );
+	std::vector<double> seconds;
+	unsigned long long instructions = 0;
+	for ( unsigned int i = 0; i < runs; i++ )
+	{
+		StringInput in( input );
+		Console console( NULL, false );
+		CPU cpu( in, console );
+		try
+		{
+			cpu.loadPrograms( w.images );
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			cpu.run( engine, w.limit );
+			seconds.push_back( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+		}
+		catch ( const std::exception& err )
+		{
+			std::cerr << w.name << ": " << err.what() << '\n';
+			return false;
+		}
+		if ( i > 0 && cpu.getInstructionCount() != instructions )
+		{
+			std::cerr << w.name << ": instruction count changed between runs\n";
+			return false;
+		}
+		instructions = cpu.getInstructionCount();
+	}
+
+	double sum = 0, min = seconds[0];
+	for ( const double s : seconds )
+	{
+		sum += s;
+		min = s < min ? s : min;
+	}
+	const double mean = sum / runs;
+	double squares = 0;
+	for ( const double s : seconds )
+	{
+		squares += ( s - mean ) * ( s - mean );
+	}
+	const double stddev = runs > 1 ? std::sqrt( squares / ( runs - 1 ) ) : 0;
+	const double mips = instructions / mean / 1e6;
+	const double cv = 100 * stddev / mean;
+
+	out << w.name << '\t' << engineNames[engine] << '\t' << runs << '\t' << instructions << '\t'
+		<< std::fixed << std::setprecision( 6 ) << mean << '\t' << stddev << '\t' << min << '\t'
+		<< std::setprecision( 2 ) << mips << '\t' << cv << '\n' << std::defaultfloat;
+	std::cerr << std::left << std::setw( 10 ) << w.name << std::right << std::setw( 12 ) << instructions << " instructions"
+		<< std::fixed << std::setprecision( 3 ) << std::setw( 9 ) << mean << " s +/- " << std::setprecision( 1 ) << cv << "%"
+		<< std::setprecision( 1 ) << std::setw( 9 ) << mips << " MIPS\n" << std::defaultfloat;
+	return true;
+}
+
+std::string
+Bench::readFile( const std::string& path )
+{
+	std::ifstream f( path, std::ios::binary );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + path );
+	}
+	std::ostringstream contents;
+	contents << f.rdbuf();
+	return contents.str();
+}
@@ -0,0 +1,30 @@
+#ifndef BENCH_HH
+#define BENCH_HH
+
+#include "CPU.hh"
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Bench
+{
+	public:
+		Bench( const Engine e, const unsigned int repeats );
+		int run( const char* suite, std::ostream& out );
+	private:
+		struct Workload
+		{
+			std::string name;
+			unsigned long long limit;
+			std::string input;
+			std::vector<std::string> images;
+		};
+		Engine engine;
+		unsigned int runs;
+		std::vector<Workload> workloads;
+		void readSuite( const char* suite );
+		bool measure( const Workload& w, std::ostream& out );
+		std::string readFile( const std::string& path );
+};
+
+#endif
@@ -1,42 +1,14 @@
 #include "CPU.hh"
-#include <iostream>
-#include <fstream>
-#include <cmath>
+#include "Input.hh"
+#include "Console.hh"
+#include "Hooks.hh"
+#include "Image.hh"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <memory>
 #include <stdexcept>
 
-#define WINDOWS __CYGWIN__ || _WIN32
-
-#if WINDOWS
-
-#include <Windows.h>
-#include <conio.h>
-
-bool
-Memory::checkSTDIN()
-{
-	HANDLE hStdin = GetStdHandle( STD_INPUT_HANDLE );
-	return WaitForSingleObject( hStdin, 1000 ) == WAIT_OBJECT_0 && _kbhit();
-}
-
-#else
-
-#include <unistd.h>
-
-bool
-Memory::checkSTDIN()
-{
-	fd_set readfds;
-	FD_ZERO( &readfds );
-	FD_SET( STDIN_FILENO, &readfds );
-
-	struct timeval timeout;
-	timeout.tv_sec = 0;
-	timeout.tv_usec = 0;
-	return select( 1, &readfds, NULL, NULL, &timeout ) != 0;
-}
-
-#endif
-
 enum
 {
 	P = 1,
@@ -44,8 +16,13 @@ enum
 	N = 4,
 	KBSR = 0xFE00,
 	KBDR = 0xFE02,
+	DSR = 0xFE04,
+	DDR = 0xFE06,
+	MCR = 0xFFFE,
 	PC_START = 0x3000,
 	PSR_START = 0x700,
+	IDLE_POLLS = 32,
+	IDLE_WAIT_MS = 10
 };
 
 enum Opcode
@@ -78,75 +55,161 @@ enum Traps
 	HALT
 };
 
-unsigned short&
-Memory::operator[]( const unsigned short addr )
+Memory::Memory( Input& in, Console& con ) : mem(), devicePage(), idlePolls( 0 ), idleWait( true ), input( in ), console( con )
+{
+	devicePage[KBSR >> PAGE_SHIFT] = true;
+	mem[DSR] = 0x8000;
+	mem[MCR] = 0x8000;
+}
+
+bool
+Memory::isDevice( const unsigned short addr )
+{
+	return devicePage[addr >> PAGE_SHIFT];
+}
+
+bool
+Memory::isClockEnabled()
+{
+	return mem[MCR] & 0x8000;
+}
+
+unsigned int
+Memory::getIdlePolls()
+{
+	return idlePolls;
+}
+
+void
+Memory::clearIdlePolls()
+{
+	idlePolls = 0;
+}
+
+void
+Memory::setIdleWait( const bool block )
+{
+	idleWait = block;
+}
+
+unsigned short
+Memory::read( const unsigned short addr )
+{
+	return isDevice( addr ) ? readDevice( addr ) : mem[addr];
+}
+
+void
+Memory::write( const unsigned short addr, const unsigned short val )
+{
+	if ( isDevice( addr ) )
+	{
+		writeDevice( addr, val );
+	}
+	else
+	{
+		mem[addr] = val;
+	}
+}
+
+unsigned short
+Memory::readDevice( const unsigned short addr )
 {
 	if ( addr == KBSR )
 	{
-		if ( checkSTDIN() )
+		console.flush();
+		if ( input.isReady() )
 		{
 			mem[addr] = 0x8000;
-			mem[KBDR] = getchar();
+			mem[KBDR] = input.get();
+			idlePolls = 0;
 		}
 		else
 		{
 			mem[addr] = 0;
+			if ( ++idlePolls >= IDLE_POLLS && idleWait )
+			{
+				input.wait( IDLE_WAIT_MS );
+				idlePolls = 0;
+			}
 		}
 	}
 	return mem[addr];
 }
 
-
-CPU::CPU() : halted( false ), PC( PC_START ), PSR( PSR_START ) { }
-
 void
-CPU::loadPrograms( int argc, char* argv[] )
+Memory::writeDevice( const unsigned short addr, const unsigned short val )
 {
-	for ( int i = 1; i < argc; i++ )
+	switch ( addr )
 	{
-		loadProgram( argv[i] );	
+		case DDR:
+		{
+			console.put( static_cast<char>( val ) );
+			idlePolls = 0;
+			break;
+		}
+		case DSR:
+		{
+			break;
+		}
+		default:
+		{
+			mem[addr] = val;
+		}
 	}
 }
 
-unsigned short
-CPU::toLittleEndian( const unsigned short val )
+unsigned short*
+Memory::data()
 {
-	return ( val << 8 ) | ( val >> 8 );
+	return mem;
 }
 
+CPU::CPU( Input& in, Console& con ) : halted( false ), waiting( false ), blocking( true ), input( in ), console( con ), mem( in, con ), PC( PC_START ), PSR( PSR_START ), ccResult( 0 ), ccLazy( false ), instret( 0 ), budget( 0 ), cache(), jit( NULL ), profiler( NULL ), tracer( NULL ), monitor( NULL ), exactCount( false ) { }
+
 void
-CPU::loadProgram( const char* filePath )
+CPU::loadPrograms( const std::vector<std::string>& paths )
 {
-	std::ifstream f;
-	f.open( filePath, std::ios::binary );
-	
-	if ( !f.is_open() )
+	std::vector<std::unique_ptr<Image>> owned;
+	std::vector<const Image*> images;
+	for ( const std::string& path : paths )
 	{
-		throw std::runtime_error( "Can not open: " + std::string( filePath ) );
+		owned.emplace_back( new Image( path ) );
+		images.push_back( owned.back().get() );
 	}
+	loadImages( images );
+}
 
-	f.seekg (0, f.end);
-	int length = f.tellg();
-	f.seekg (0, f.beg);
-
-	if ( length > MEM_SIZE * 2 )
+void
+CPU::loadImages( const std::vector<const Image*>& images )
+{
+	std::vector<const Image*> sorted( images );
+	std::sort( sorted.begin(), sorted.end(), []( const Image* a, const Image* b )
 	{
-		throw std::runtime_error( std::string( filePath ) + " is too large" );
-	}  
-
-	unsigned short origin[1];
-
-	f.read( reinterpret_cast<char*>( origin ), 2 );
-	origin[0] = toLittleEndian( origin[0] );
-	unsigned short* p = &mem[0] + origin[0];
-	
-	f.read( reinterpret_cast<char*>( p ), length - 2); 
-	f.close();
-
-	for ( int i = 0; i < round( ( length - 2 ) / 2.0 ); i++ )
+		return a->getOrigin() < b->getOrigin();
+	} );
+	const Image* furthest = NULL;
+	size_t end = 0;
+	for ( const Image* image : sorted )
 	{
-		*p = toLittleEndian( *p );
-		p++;		
+		if ( image->getOrigin() + image->getSize() > MEM_SIZE )
+		{
+			throw std::runtime_error( image->getPath() + " runs past the end of memory" );
+		}
+		if ( image->getSize() && image->getOrigin() < end )
+		{
+			throw std::runtime_error( image->getPath() + " overlaps " + furthest->getPath() );
+		}
+		if ( image->getOrigin() + image->getSize() > end )
+		{
+			furthest = image;
+			end = image->getOrigin() + image->getSize();
+		}
+	}
+	discardJIT();
+	for ( const Image* image : images )
+	{
+		image->copyTo( mem.data() );
+		std::memset( cache + image->getOrigin(), 0, image->getSize() * sizeof( Decoded ) );
 	}
 }
 
@@ -156,22 +219,133 @@ CPU::isHalted()
 	return halted;
 }
 
+bool
+CPU::isWaiting()
+{
+	return waiting || mem.getIdlePolls() >= IDLE_POLLS;
+}
+
+bool
+CPU::hasInput()
+{
+	return input.isReady();
+}
+
 void
-CPU::setcc( const unsigned short val )
+CPU::setBlocking( const bool block )
 {
-	PSR &= 0xFFF8;
-	if ( val & 0x8000 )
-	{
-		PSR |= N;
-	}
-	else if ( val == 0 )
+	blocking = block;
+	mem.setIdleWait( block );
+}
+
+void
+CPU::setProfiler( Profiler* p )
+{
+	profiler = p;
+}
+
+void
+CPU::setTracer( Tracer* t )
+{
+	tracer = t;
+	if ( tracer )
 	{
-		PSR |= Z;
+		tracer->begin( *this );
 	}
-	else
+}
+
+void
+CPU::setMonitor( Monitor* m )
+{
+	monitor = m;
+}
+
+void
+CPU::setBreakpoint( const unsigned short addr )
+{
+	breakpoints.resize( MEM_SIZE );
+	breakpoints[addr] = true;
+}
+
+void
+CPU::setExactCount( const bool exact )
+{
+	exactCount = exact;
+}
+
+unsigned long long
+CPU::getInstructionCount()
+{
+	return instret;
+}
+
+unsigned short
+CPU::getRegister( const int reg )
+{
+	return GPR[reg];
+}
+
+void
+CPU::setRegister( const int reg, const unsigned short val )
+{
+	GPR[reg] = val;
+}
+
+unsigned short
+CPU::getPC()
+{
+	return PC;
+}
+
+void
+CPU::setPC( const unsigned short addr )
+{
+	PC = addr;
+}
+
+unsigned short
+CPU::getPSR()
+{
+	syncPSR();
+	return PSR;
+}
+
+unsigned short
+CPU::readMemory( const unsigned short addr )
+{
+	return mem.data()[addr];
+}
+
+void
+CPU::writeMemory( const unsigned short addr, const unsigned short val )
+{
+	discardJIT();
+	mem.data()[addr] = val;
+	cache[addr].form = UNDECODED;
+}
+
+void
+CPU::setcc( const unsigned short val )
+{
+	ccResult = val;
+	ccLazy = true;
+}
+
+unsigned short
+CPU::getcc()
+{
+	if ( !ccLazy )
 	{
-		PSR |= P;
+		return PSR & 0x7;
 	}
+	return ccResult & 0x8000 ? N : ccResult ? P : Z;
+}
+
+void
+CPU::syncPSR()
+{
+	PSR = ( PSR & 0xFFF8 ) | getcc();
+	ccLazy = false;
 }
 
 unsigned short
@@ -187,67 +361,57 @@ CPU::sext( unsigned short val, const int len )
 unsigned short
 CPU::fetchInstr()
 {
-	return mem[PC++];
+	return mem.read( PC++ );
 }
 
 void
-CPU::handleTrap( const unsigned short instr )
+CPU::handleTrap( const unsigned short vector )
 {
+	mem.clearIdlePolls();
+	if ( !blocking && ( vector == GETC || vector == IN ) && !input.isReady() )
+	{
+		PC--;
+		waiting = true;
+		return;
+	}
 	GPR[7] = PC;
-	switch ( instr & 0xFF )
+	switch ( vector )
 	{
 		case GETC:
 		{
-			GPR[0] = static_cast<unsigned short>( getchar() );
+			console.flush();
+			GPR[0] = static_cast<unsigned short>( input.get() );
 			setcc( GPR[0] );
 			break;
 		}
 		case OUT:
 		{
-			std::cout << static_cast<char>( GPR[0] );
-			std::cout.flush();
+			console.put( static_cast<char>( GPR[0] ) );
 			break;
 		}
 		case PUTS:
 		{
-			unsigned short* c = &mem[0] + GPR[0];
-			while ( *c )
-			{
-				std::cout << static_cast<char>( *c );
-				c++;
-			} 
-			std::cout.flush();
+			console.puts( mem.data() + GPR[0], MEM_SIZE - GPR[0] );
 			break;
 		}
 		case IN:
 		{
-			std::cout << "Enter a character: ";
-			char c = getchar();
-			std::cout << c;
-			std::cout.flush();
+			console.write( "Enter a character: " );
+			console.flush();
+			char c = input.get();
+			console.put( c );
 			GPR[0] = static_cast<unsigned short>( c );
 			setcc( GPR[0] );
 			break;
 		}
 		case PUTSP:
 		{
-			unsigned short* c = &mem[0] + GPR[0];
-			while ( *c )
-			{
-				char c1 = static_cast<char>( *c );
-				std::cout << c1;
-				char c2 = static_cast<char>( *c >> 8 );
-				if ( c2 )
-				{
-					std::cout << c2;
-				}
-				c++;
-			}
-			std::cout.flush();
+			console.putsPacked( mem.data() + GPR[0], MEM_SIZE - GPR[0] );
 			break;
 		}
 		case HALT:
 		{
+			console.flush();
 			halted = true;
 			break;
 		}
@@ -261,90 +425,211 @@ CPU::halt()
 }
 
 void
-CPU::handleInstr( const unsigned short instr )
+CPU::store( const unsigned short addr, const unsigned short val )
+{
+	mem.write( addr, val );
+	cache[addr].form = UNDECODED;
+	if ( mem.isDevice( addr ) && !mem.isClockEnabled() )
+	{
+		halted = true;
+	}
+}
+
+template <class Hooks>
+unsigned short
+CPU::load( const unsigned short addr, Hooks& hooks )
 {
-	unsigned short r0, r1, r2, imm, imm5, offBase, offPC;
+	const unsigned short val = mem.read( addr );
+	hooks.load( addr, val );
+	return val;
+}
+
+template <class Hooks>
+void
+CPU::store( const unsigned short addr, const unsigned short val, Hooks& hooks )
+{
+	hooks.store( addr, val );
+	store( addr, val );
+}
+
+static const unsigned char forms[] =
+{
+	BR_FORM, ADD_REG, LD_FORM, ST_FORM, JSR_FORM, AND_REG, LDR_FORM, STR_FORM,
+	RTI_FORM, NOT_FORM, LDI_FORM, STI_FORM, JMP_FORM, RES_FORM, LEA_FORM, TRAP_FORM
+};
+
+Decoded
+CPU::decode( const unsigned short addr, const unsigned short instr )
+{
+	Decoded d = Decoded();
 	const unsigned short opcode = instr >> 12;
 	const unsigned short opbit = 1 << opcode;
+	const unsigned short next = addr + 1;
 
+	d.opcode = opcode;
+	d.form = forms[opcode];
 	if ( opbit & 0x4EEF )
 	{
-		r0 = ( instr >> 9 ) & 0x7; 
+		d.r0 = ( instr >> 9 ) & 0x7; 
 	} 
 	if ( opbit & 0x12F3 )
 	{
-		r1 = ( instr >> 6 ) & 0x7;
+		d.r1 = ( instr >> 6 ) & 0x7;
 	}
 	if ( opbit & 0x22 )
 	{
-		imm = instr & 0x20;
-		if ( imm )
+		d.imm = instr & 0x20;
+		if ( d.imm )
 		{
-			imm5 = sext( instr & 0x1F, 5 );
+			d.val = sext( instr & 0x1F, 5 );
+			d.form++;
 		}
 		else
 		{
-			r2 = instr & 0x7;
+			d.r2 = instr & 0x7;
 		}
 	}
 	if ( opbit & 0xC0 )
 	{
-		offBase = GPR[r1] + sext( instr & 0x3F, 6 );
+		d.val = sext( instr & 0x3F, 6 );
 	}
 	else if ( opbit & 0x4C0D )
 	{
-		offPC = PC + sext( instr & 0x1FF, 9 );
+		d.val = next + sext( instr & 0x1FF, 9 );
 	} 
+	else if ( opcode == JSR )
+	{
+		d.imm = instr & 0x800;
+		d.form = d.imm ? JSR_FORM : JSRR_FORM;
+		d.val = next + sext( instr & 0x7FF, 11 );
+	}
+	else if ( opcode == TRAP )
+	{
+		d.val = instr & 0xFF;
+	}
+	return d;
+}
+
+void
+CPU::fuse( const unsigned short addr )
+{
+	const unsigned short next = addr + 1;
+	if ( next >= KBSR )
+	{
+		return;
+	}
+	Decoded& d = cache[addr];
+	const Decoded n = cache[next].form ? cache[next] : decode( next, mem.read( next ) );
+	if ( d.form == AND_IMM && d.val == 0 && n.form == ADD_IMM && n.r1 == d.r0 )
+	{
+		d.form = CLEAR_ADD_FUSED;
+	}
+	else if ( d.form == ADD_IMM && n.form == BR_FORM )
+	{
+		d.form = ADD_BR_FUSED;
+	}
+}
+
+void
+CPU::step()
+{
+	NoHooks none;
+	step( none );
+}
+
+template <class Hooks>
+void
+CPU::step( Hooks& hooks )
+{
+	Decoded* d = &cache[PC];
+	Decoded uncached;
+	if ( !d->form )
+	{
+		uncached = decode( PC, mem.read( PC ) );
+		if ( PC < KBSR )
+		{
+			*d = uncached;
+		}
+		else
+		{
+			d = &uncached;
+		}
+	}
+	PC++;
+	execute( *d, hooks );
+}
+
+void
+CPU::handleInstr( const unsigned short instr )
+{
+	execute( decode( PC - 1, instr ) );
+}
 
-	switch ( opcode )
+void
+CPU::execute( const Decoded& d )
+{
+	NoHooks none;
+	execute( d, none );
+}
+
+template <class Hooks>
+void
+CPU::execute( const Decoded& d, Hooks& hooks )
+{
+	switch ( d.opcode )
 	{
 		case BR:
 		{
-			PC = ( PSR & 0x7 ) & r0 ? offPC : PC;
+			PC = getcc() & d.r0 ? d.val : PC;
 			break;
 		}
 		case ADD:
 		{
-			GPR[r0] = imm ? GPR[r1] + imm5 : GPR[r1] + GPR[r2];
+			GPR[d.r0] = d.imm ? GPR[d.r1] + d.val : GPR[d.r1] + GPR[d.r2];
+			setcc( GPR[d.r0] );
 			break;
 		}
 		case LD:
 		{
-			GPR[r0] = mem[offPC];
+			GPR[d.r0] = load( d.val, hooks );
+			setcc( GPR[d.r0] );
 			break;
 		}
 		case ST:
 		{
-			mem[offPC] = GPR[r0];
+			store( d.val, GPR[d.r0], hooks );
 			break;
 		}
 		case JSR:
 		{
 			GPR[7] = PC;
-			PC = instr & 0x800 ? PC + sext( instr & 0x7FF, 11 ) : GPR[r1];
+			PC = d.imm ? d.val : GPR[d.r1];
 			break;
 		}
 		case AND:
 		{
-			GPR[r0] = imm ? GPR[r1] & imm5 : GPR[r1] & GPR[r2];
+			GPR[d.r0] = d.imm ? GPR[d.r1] & d.val : GPR[d.r1] & GPR[d.r2];
+			setcc( GPR[d.r0] );
 			break;
 		}
 		case LDR:
 		{
-			GPR[r0] = mem[offBase];
+			GPR[d.r0] = load( GPR[d.r1] + d.val, hooks );
+			setcc( GPR[d.r0] );
 			break;
 		}
 		case STR:
 		{
-			mem[offBase] = GPR[r0];
+			store( GPR[d.r1] + d.val, GPR[d.r0], hooks );
 			break;
 		}
 		case RTI:
 		{
 			if ( !( PSR & 0x8000 ) )
 			{
-				PC = mem[GPR[6]++];
-				PSR = mem[GPR[6]++];
+				PC = load( GPR[6]++, hooks );
+				PSR = load( GPR[6]++, hooks );
+				ccLazy = false;
 				break;
 			}
 			else
@@ -354,42 +639,353 @@ CPU::handleInstr( const unsigned short instr )
 		}
 		case NOT:
 		{
-			GPR[r0] = ~GPR[r1];
+			GPR[d.r0] = ~GPR[d.r1];
+			setcc( GPR[d.r0] );
 			break;
 		}
 		case LDI:
 		{
-			GPR[r0] = mem[mem[offPC]];
+			GPR[d.r0] = load( load( d.val, hooks ), hooks );
+			setcc( GPR[d.r0] );
 			break;
 		}
 		case STI:
 		{
-			mem[mem[offPC]] = GPR[r0];
+			store( load( d.val, hooks ), GPR[d.r0], hooks );
 			break;
 		}
 		case JMP:
 		{
-			PC = GPR[r1];
+			PC = GPR[d.r1];
 			break;
 		}
 		case LEA:
 		{
-			GPR[r0] = offPC;
+			GPR[d.r0] = d.val;
+			setcc( GPR[d.r0] );
 			break;
 		}
 		case TRAP:
 		{
-			handleTrap( instr ); 
+			hooks.trap( d.val );
+			handleTrap( d.val );
 			break;
 		}
 		default:
 		{
-			throw std::runtime_error( "Invalid Opcode: " + std::to_string( opcode ) );
+			throw std::runtime_error( "Invalid Opcode: " + std::to_string( d.opcode ) );
 		}
 	}
-	
-	if ( opbit & 0x4666 )
+}
+
+void
+CPU::run( const Engine engine )
+{
+	run( engine, ULLONG_MAX );
+}
+
+void
+CPU::run( const Engine engine, const unsigned long long limit )
+{
+	waiting = false;
+	const bool instrumented = profiler || tracer || monitor || !breakpoints.empty() || exactCount;
+	if ( engine == JIT_ENGINE && !instrumented )
+	{
+		runJIT( limit );
+	}
+	else if ( instrumented )
+	{
+		discardJIT();
+		runStepped( limit );
+	}
+	else if ( engine == THREADED_ENGINE )
+	{
+		discardJIT();
+		runThreaded( limit );
+	}
+	else
+	{
+		discardJIT();
+		runSwitch( limit );
+	}
+	syncPSR();
+}
+
+void
+CPU::runSwitch( const unsigned long long limit )
+{
+	unsigned long long executed = 0;
+	while ( !halted && !waiting && executed < limit )
+	{
+		step();
+		executed++;
+	}
+	instret += executed;
+}
+
+void
+CPU::runStepped( const unsigned long long limit )
+{
+	if ( profiler )
+	{
+		ProfileHooks hooks( *profiler );
+		runMonitored( limit, hooks );
+	}
+	else
+	{
+		NoHooks hooks;
+		runMonitored( limit, hooks );
+	}
+}
+
+template <class Hooks>
+void
+CPU::runMonitored( const unsigned long long limit, Hooks& hooks )
+{
+	if ( monitor )
+	{
+		MonitorHooks counters( *monitor, console );
+		ChainHooks<Hooks, MonitorHooks> chain( hooks, counters );
+		runTraced( limit, chain );
+	}
+	else
 	{
-		setcc( GPR[r0] );
+		runTraced( limit, hooks );
 	}
 }
+
+template <class Hooks>
+void
+CPU::runTraced( const unsigned long long limit, Hooks& hooks )
+{
+	if ( tracer )
+	{
+		TraceHooks trace( *tracer );
+		ChainHooks<Hooks, TraceHooks> chain( hooks, trace );
+		runBreakable( limit, chain );
+	}
+	else
+	{
+		runBreakable( limit, hooks );
+	}
+}
+
+template <class Hooks>
+void
+CPU::runBreakable( const unsigned long long limit, Hooks& hooks )
+{
+	if ( !breakpoints.empty() )
+	{
+		BreakHooks stop( breakpoints );
+		ChainHooks<BreakHooks, Hooks> chain( stop, hooks );
+		runHooked( limit, chain );
+	}
+	else
+	{
+		runHooked( limit, hooks );
+	}
+}
+
+template <class Hooks>
+void
+CPU::runHooked( const unsigned long long limit, Hooks& hooks )
+{
+	const unsigned long long start = instret;
+	const unsigned long long end = limit < ULLONG_MAX - instret ? instret + limit : ULLONG_MAX;
+	while ( !halted && !waiting && instret < end )
+	{
+		if ( instret != start && hooks.stopAt( PC ) )
+		{
+			break;
+		}
+		hooks.fetch( PC, mem.data()[PC] );
+		step( hooks );
+		hooks.retire( GPR, getcc() );
+		instret++;
+	}
+}
+
+#if defined( __GNUC__ )
+
+void
+CPU::runThreaded( const unsigned long long limit )
+{
+	static void* const handlers[] =
+	{
+		&&undecoded, &&br, &&addReg, &&addImm, &&ld, &&st, &&jsr, &&jsrr,
+		&&andReg, &&andImm, &&ldr, &&str, &&rti, &&notOp, &&ldi, &&sti,
+		&&jmp, &&res, &&lea, &&trap, &&clearAdd, &&addBr
+	};
+	Decoded* d;
+	Decoded uncached;
+	unsigned long long remaining = limit;
+
+#define DISPATCH() if ( !remaining ) goto done; remaining--; d = &cache[PC++]; goto *handlers[d->form]
+
+	if ( halted )
+	{
+		return;
+	}
+	DISPATCH();
+
+	undecoded:
+	{
+		const unsigned short addr = PC - 1;
+		uncached = decode( addr, mem.read( addr ) );
+		if ( addr < KBSR )
+		{
+			*d = uncached;
+			fuse( addr );
+		}
+		else
+		{
+			d = &uncached;
+		}
+		goto *handlers[d->form];
+	}
+	br:
+	{
+		PC = getcc() & d->r0 ? d->val : PC;
+		DISPATCH();
+	}
+	addReg:
+	{
+		setcc( GPR[d->r0] = GPR[d->r1] + GPR[d->r2] );
+		DISPATCH();
+	}
+	addImm:
+	{
+		setcc( GPR[d->r0] = GPR[d->r1] + d->val );
+		DISPATCH();
+	}
+	ld:
+	{
+		setcc( GPR[d->r0] = mem.read( d->val ) );
+		DISPATCH();
+	}
+	st:
+	{
+		store( d->val, GPR[d->r0] );
+		if ( halted )
+		{
+			goto done;
+		}
+		DISPATCH();
+	}
+	jsr:
+	{
+		GPR[7] = PC;
+		PC = d->val;
+		DISPATCH();
+	}
+	jsrr:
+	{
+		GPR[7] = PC;
+		PC = GPR[d->r1];
+		DISPATCH();
+	}
+	andReg:
+	{
+		setcc( GPR[d->r0] = GPR[d->r1] & GPR[d->r2] );
+		DISPATCH();
+	}
+	andImm:
+	{
+		setcc( GPR[d->r0] = GPR[d->r1] & d->val );
+		DISPATCH();
+	}
+	ldr:
+	{
+		setcc( GPR[d->r0] = mem.read( GPR[d->r1] + d->val ) );
+		DISPATCH();
+	}
+	str:
+	{
+		store( GPR[d->r1] + d->val, GPR[d->r0] );
+		if ( halted )
+		{
+			goto done;
+		}
+		DISPATCH();
+	}
+	notOp:
+	{
+		setcc( GPR[d->r0] = ~GPR[d->r1] );
+		DISPATCH();
+	}
+	ldi:
+	{
+		setcc( GPR[d->r0] = mem.read( mem.read( d->val ) ) );
+		DISPATCH();
+	}
+	sti:
+	{
+		store( mem.read( d->val ), GPR[d->r0] );
+		if ( halted )
+		{
+			goto done;
+		}
+		DISPATCH();
+	}
+	jmp:
+	{
+		PC = GPR[d->r1];
+		DISPATCH();
+	}
+	lea:
+	{
+		setcc( GPR[d->r0] = d->val );
+		DISPATCH();
+	}
+	clearAdd:
+	{
+		const Decoded* n = &cache[PC];
+		if ( ( n->form != ADD_IMM && n->form != ADD_BR_FUSED ) || n->r1 != d->r0 || !remaining )
+		{
+			goto andImm;
+		}
+		remaining--;
+		GPR[d->r0] = 0;
+		setcc( GPR[n->r0] = n->val );
+		PC++;
+		DISPATCH();
+	}
+	addBr:
+	{
+		const Decoded* n = &cache[PC];
+		if ( n->form != BR_FORM || !remaining )
+		{
+			goto addImm;
+		}
+		remaining--;
+		setcc( GPR[d->r0] = GPR[d->r1] + d->val );
+		PC = getcc() & n->r0 ? n->val : PC + 1;
+		DISPATCH();
+	}
+	rti:
+	res:
+	trap:
+	{
+		execute( *d );
+		if ( halted || waiting )
+		{
+			goto done;
+		}
+		DISPATCH();
+	}
+
+	done:
+	instret += limit - remaining;
+
+#undef DISPATCH
+}
+
+#else
+
+void
+CPU::runThreaded( const unsigned long long limit )
+{
+	runSwitch( limit );
+}
+
+#endif
@@ -1,37 +1,169 @@
+#ifndef CPU_HH
+#define CPU_HH
+
+#include <string>
+#include <vector>
+
 enum
 {
 	MEM_SIZE = 65536,
-	GPR_COUNT = 8
+	GPR_COUNT = 8,
+	PAGE_SHIFT = 9,
+	PAGE_COUNT = MEM_SIZE >> PAGE_SHIFT
+};
+
+enum Engine
+{
+	SWITCH_ENGINE,
+	THREADED_ENGINE,
+	JIT_ENGINE,
+	LOCKSTEP_ENGINE
+};
+
+enum Form
+{
+	UNDECODED,
+	BR_FORM,
+	ADD_REG,
+	ADD_IMM,
+	LD_FORM,
+	ST_FORM,
+	JSR_FORM,
+	JSRR_FORM,
+	AND_REG,
+	AND_IMM,
+	LDR_FORM,
+	STR_FORM,
+	RTI_FORM,
+	NOT_FORM,
+	LDI_FORM,
+	STI_FORM,
+	JMP_FORM,
+	RES_FORM,
+	LEA_FORM,
+	TRAP_FORM,
+	CLEAR_ADD_FUSED,
+	ADD_BR_FUSED
+};
+
+class Input;
+class Console;
+class JIT;
+class Profiler;
+class Monitor;
+class Tracer;
+class Image;
+
+struct Decoded
+{
+	unsigned char opcode;
+	unsigned char r0, r1, r2;
+	unsigned char form;
+	bool imm;
+	unsigned short val;
 };
 
 class Memory
 {
 	public:
-		unsigned short& operator[]( const unsigned short addr );
+		Memory( Input& in, Console& con );
+		unsigned short read( const unsigned short addr );
+		void write( const unsigned short addr, const unsigned short val );
+		bool isDevice( const unsigned short addr );
+		bool isClockEnabled();
+		unsigned int getIdlePolls();
+		void clearIdlePolls();
+		void setIdleWait( const bool block );
+		unsigned short* data();
 	private:
 		unsigned short mem[MEM_SIZE];
-		bool checkSTDIN();
+		bool devicePage[PAGE_COUNT];
+		unsigned int idlePolls;
+		bool idleWait;
+		unsigned short readDevice( const unsigned short addr );
+		void writeDevice( const unsigned short addr, const unsigned short val );
+		Input& input;
+		Console& console;
 };
 
 class CPU
 {
+	friend class JIT;
+	friend class Lockstep;
+	friend class Native;
 	public:
-		CPU();
+		CPU( Input& in, Console& con );
+		~CPU();
 		void setUp();
 		void cleanUp();
 		unsigned short fetchInstr(); 
 		void handleInstr( const unsigned short instr );
+		void step();
+		void run( const Engine engine );
+		void run( const Engine engine, const unsigned long long limit );
 		void halt();
 		bool isHalted();
-		void loadPrograms( int argc, char* argv[] );
+		bool isWaiting();
+		bool hasInput();
+		void setBlocking( const bool block );
+		void setProfiler( Profiler* p );
+		void setTracer( Tracer* t );
+		void setMonitor( Monitor* m );
+		void setBreakpoint( const unsigned short addr );
+		void setExactCount( const bool exact );
+		unsigned long long getInstructionCount();
+		unsigned short getRegister( const int reg );
+		void setRegister( const int reg, const unsigned short val );
+		unsigned short getPC();
+		void setPC( const unsigned short addr );
+		unsigned short getPSR();
+		unsigned short readMemory( const unsigned short addr );
+		void writeMemory( const unsigned short addr, const unsigned short val );
+		void loadPrograms( const std::vector<std::string>& paths );
+		void loadImages( const std::vector<const Image*>& images );
+		void saveSnapshot( const char* filePath );
+		void restoreSnapshot( const char* filePath );
 	private:
-		bool halted;
+		bool halted, waiting, blocking;
+		Input& input;
+		Console& console;
 		Memory mem;
 		unsigned short GPR[GPR_COUNT];
 		unsigned short PC, PSR;
-		void handleTrap( const unsigned short instr );
+		unsigned short ccResult;
+		bool ccLazy;
+		unsigned long long instret;
+		long long budget;
+		Decoded cache[MEM_SIZE];
+		JIT* jit;
+		Profiler* profiler;
+		Tracer* tracer;
+		Monitor* monitor;
+		std::vector<bool> breakpoints;
+		bool exactCount;
+		Decoded decode( const unsigned short addr, const unsigned short instr );
+		void execute( const Decoded& d );
+		template <class Hooks> void step( Hooks& hooks );
+		template <class Hooks> void execute( const Decoded& d, Hooks& hooks );
+		template <class Hooks> unsigned short load( const unsigned short addr, Hooks& hooks );
+		template <class Hooks> void store( const unsigned short addr, const unsigned short val, Hooks& hooks );
+		void fuse( const unsigned short addr );
+		void runSwitch( const unsigned long long limit );
+		void runThreaded( const unsigned long long limit );
+		void runStepped( const unsigned long long limit );
+		template <class Hooks> void runMonitored( const unsigned long long limit, Hooks& hooks );
+		template <class Hooks> void runTraced( const unsigned long long limit, Hooks& hooks );
+		template <class Hooks> void runBreakable( const unsigned long long limit, Hooks& hooks );
+		template <class Hooks> void runHooked( const unsigned long long limit, Hooks& hooks );
+		void runJIT( const unsigned long long limit );
+		void discardJIT();
+		void store( const unsigned short addr, const unsigned short val );
+		void handleTrap( const unsigned short vector );
 		unsigned short sext( unsigned short val, const int len );
 		void setcc( const unsigned short val );
-		void loadProgram( const char* filePath ); 
-		unsigned short toLittleEndian( unsigned short val );
+		unsigned short getcc();
+		void syncPSR();
+		void restoreState( const char* filePath, const char* snapshot );
 };
+
+#endif
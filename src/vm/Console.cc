@@ -0,0 +1,150 @@
+#include "Console.hh"
+#include <chrono>
+
+Console::Console( std::FILE* stream, const bool timed ) : out( stream ), sink( NULL ), sinkUser( NULL ), used( 0 ), written( 0 ), pending( false ), stopping( false )
+{
+	if ( timed )
+	{
+		timer = std::thread( &Console::timerLoop, this );
+	}
+}
+
+Console::Console( Sink callback, void* user ) : out( NULL ), sink( callback ), sinkUser( user ), used( 0 ), written( 0 ), pending( false ), stopping( false ) { }
+
+Console::~Console()
+{
+	{
+		std::lock_guard<std::mutex> guard( lock );
+		stopping = true;
+	}
+	wake.notify_all();
+	if ( timer.joinable() )
+	{
+		timer.join();
+	}
+	flush();
+}
+
+void
+Console::put( const char c )
+{
+	std::lock_guard<std::mutex> guard( lock );
+	append( c );
+	markPending();
+}
+
+void
+Console::write( const char* str )
+{
+	std::lock_guard<std::mutex> guard( lock );
+	while ( *str )
+	{
+		append( *str++ );
+	}
+	markPending();
+}
+
+void
+Console::puts( const unsigned short* str, const size_t limit )
+{
+	std::lock_guard<std::mutex> guard( lock );
+	size_t i = 0;
+	while ( i < limit && str[i] )
+	{
+		if ( used == BUFFER_SIZE )
+		{
+			drain();
+		}
+		const size_t end = i + BUFFER_SIZE - used < limit ? i + BUFFER_SIZE - used : limit;
+		while ( i < end && str[i] )
+		{
+			buffer[used++] = static_cast<char>( str[i++] );
+		}
+	}
+	markPending();
+}
+
+void
+Console::putsPacked( const unsigned short* str, const size_t limit )
+{
+	std::lock_guard<std::mutex> guard( lock );
+	for ( size_t i = 0; i < limit && str[i]; i++ )
+	{
+		append( static_cast<char>( str[i] ) );
+		const char high = static_cast<char>( str[i] >> 8 );
+		if ( high )
+		{
+			append( high );
+		}
+	}
+	markPending();
+}
+
+void
+Console::flush()
+{
+	if ( !pending.load( std::memory_order_acquire ) )
+	{
+		return;
+	}
+	std::lock_guard<std::mutex> guard( lock );
+	drain();
+}
+
+unsigned long long
+Console::getBytesWritten()
+{
+	return written.load( std::memory_order_relaxed );
+}
+
+void
+Console::append( const char c )
+{
+	if ( used == BUFFER_SIZE )
+	{
+		drain();
+	}
+	buffer[used++] = c;
+}
+
+void
+Console::markPending()
+{
+	if ( used > 0 && !pending.load( std::memory_order_relaxed ) )
+	{
+		pending.store( true, std::memory_order_release );
+		wake.notify_one();
+	}
+}
+
+void
+Console::drain()
+{
+	if ( out )
+	{
+		std::fwrite( buffer, 1, used, out );
+		std::fflush( out );
+	}
+	else if ( sink && used > 0 )
+	{
+		sink( sinkUser, buffer, used );
+	}
+	written.store( written.load( std::memory_order_relaxed ) + used, std::memory_order_relaxed );
+	used = 0;
+	pending.store( false, std::memory_order_release );
+}
+
+void
+Console::timerLoop()
+{
+	std::unique_lock<std::mutex> guard( lock );
+	while ( !stopping )
+	{
+		wake.wait( guard, [this] { return stopping || pending.load( std::memory_order_relaxed ); } );
+		wake.wait_for( guard, std::chrono::milliseconds( FLUSH_DELAY_MS ), [this] { return stopping; } );
+		if ( pending.load( std::memory_order_relaxed ) )
+		{
+			drain();
+		}
+	}
+}
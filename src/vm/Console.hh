@@ -0,0 +1,47 @@
+#ifndef CONSOLE_HH
+#define CONSOLE_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+class Console
+{
+	public:
+		typedef void ( *Sink )( void* user, const char* data, size_t length );
+		Console( std::FILE* stream, const bool timed );
+		Console( Sink callback, void* user );
+		~Console();
+		void put( const char c );
+		void write( const char* str );
+		void puts( const unsigned short* str, const size_t limit );
+		void putsPacked( const unsigned short* str, const size_t limit );
+		void flush();
+		unsigned long long getBytesWritten();
+	private:
+		enum
+		{
+			BUFFER_SIZE = 65536,
+			FLUSH_DELAY_MS = 20
+		};
+		std::FILE* out;
+		Sink sink;
+		void* sinkUser;
+		char buffer[BUFFER_SIZE];
+		size_t used;
+		std::atomic<unsigned long long> written;
+		std::atomic<bool> pending;
+		bool stopping;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::thread timer;
+		void append( const char c );
+		void markPending();
+		void drain();
+		void timerLoop();
+};
+
+#endif
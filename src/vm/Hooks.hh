@@ -0,0 +1,87 @@
+#ifndef HOOKS_HH
+#define HOOKS_HH
+
+#include "Console.hh"
+#include "Monitor.hh"
+#include "Profiler.hh"
+#include "Trace.hh"
+#include <vector>
+
+struct NoHooks
+{
+	bool stopAt( const unsigned short ) { return false; }
+	void fetch( const unsigned short, const unsigned short ) { }
+	void load( const unsigned short, const unsigned short ) { }
+	void store( const unsigned short, const unsigned short ) { }
+	void trap( const unsigned short ) { }
+	void retire( const unsigned short*, const unsigned short ) { }
+};
+
+class ProfileHooks : public NoHooks
+{
+	public:
+		ProfileHooks( Profiler& p ) : profiler( p ) { }
+		void fetch( const unsigned short addr, const unsigned short instr ) { profiler.record( addr, instr ); }
+		void trap( const unsigned short vector ) { profiler.recordTrap( vector ); }
+	private:
+		Profiler& profiler;
+};
+
+class TraceHooks : public NoHooks
+{
+	public:
+		TraceHooks( Tracer& t ) : tracer( t ), addr( 0 ), instr( 0 ), stored( false ), storeAddr( 0 ), storeVal( 0 ) { }
+		void fetch( const unsigned short a, const unsigned short i ) { addr = a; instr = i; stored = false; }
+		void store( const unsigned short a, const unsigned short val ) { stored = true; storeAddr = a; storeVal = val; }
+		void retire( const unsigned short* gpr, const unsigned short cc ) { tracer.record( addr, instr, gpr, cc, stored, storeAddr, storeVal ); }
+	private:
+		Tracer& tracer;
+		unsigned short addr, instr;
+		bool stored;
+		unsigned short storeAddr, storeVal;
+};
+
+class MonitorHooks : public NoHooks
+{
+	public:
+		MonitorHooks( Monitor& m, Console& c ) : monitor( m ), console( c ), addr( 0 ) { }
+		void fetch( const unsigned short a, const unsigned short instr ) { addr = a; monitor.countOpcode( instr ); }
+		void load( const unsigned short a, const unsigned short ) { if ( a == KBSR ) monitor.countPoll(); }
+		void trap( const unsigned short vector ) { monitor.countTrap( vector ); }
+		void retire( const unsigned short*, const unsigned short ) { if ( monitor.retire() ) monitor.publish( addr, console.getBytesWritten() ); }
+	private:
+		enum
+		{
+			KBSR = 0xFE00
+		};
+		Monitor& monitor;
+		Console& console;
+		unsigned short addr;
+};
+
+class BreakHooks : public NoHooks
+{
+	public:
+		BreakHooks( const std::vector<bool>& points ) : breakpoints( points ) { }
+		bool stopAt( const unsigned short addr ) { return breakpoints[addr]; }
+	private:
+		const std::vector<bool>& breakpoints;
+};
+
+template <class First, class Second>
+class ChainHooks
+{
+	public:
+		ChainHooks( First& a, Second& b ) : first( a ), second( b ) { }
+		bool stopAt( const unsigned short addr ) { return first.stopAt( addr ) || second.stopAt( addr ); }
+		void fetch( const unsigned short addr, const unsigned short instr ) { first.fetch( addr, instr ); second.fetch( addr, instr ); }
+		void load( const unsigned short addr, const unsigned short val ) { first.load( addr, val ); second.load( addr, val ); }
+		void store( const unsigned short addr, const unsigned short val ) { first.store( addr, val ); second.store( addr, val ); }
+		void trap( const unsigned short vector ) { first.trap( vector ); second.trap( vector ); }
+		void retire( const unsigned short* gpr, const unsigned short cc ) { first.retire( gpr, cc ); second.retire( gpr, cc ); }
+	private:
+		First& first;
+		Second& second;
+};
+
+#endif
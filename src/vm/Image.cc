@@ -0,0 +1,174 @@
+#include "Image.hh"
+#include "CPU.hh"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#define WINDOWS __CYGWIN__ || _WIN32
+
+#if !( WINDOWS )
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
+
+#if defined( __SSE2__ )
+
+#include <emmintrin.h>
+
+#endif
+
+#if WINDOWS
+
+Image::Image( const std::string& filePath ) : path( filePath ), bytes( NULL ), length( 0 ), mapped( false )
+{
+	std::ifstream f( filePath, std::ios::binary );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + filePath );
+	}
+	contents.assign( std::istreambuf_iterator<char>( f ), std::istreambuf_iterator<char>() );
+	length = contents.size();
+	checkSize();
+	bytes = contents.data();
+}
+
+Image::~Image() { }
+
+#else
+
+Image::Image( const std::string& filePath ) : path( filePath ), bytes( NULL ), length( 0 ), mapped( false )
+{
+	const int fd = open( filePath.c_str(), O_RDONLY );
+	struct stat st;
+	if ( fd < 0 || fstat( fd, &st ) != 0 )
+	{
+		if ( fd >= 0 )
+		{
+			close( fd );
+		}
+		throw std::runtime_error( "Can not open: " + filePath );
+	}
+	length = st.st_size;
+	try
+	{
+		checkSize();
+	}
+	catch ( ... )
+	{
+		close( fd );
+		throw;
+	}
+	void* p = mmap( NULL, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if ( p == MAP_FAILED )
+	{
+		throw std::runtime_error( "Can not map: " + filePath );
+	}
+	bytes = static_cast<const unsigned char*>( p );
+	mapped = true;
+}
+
+Image::~Image()
+{
+	if ( mapped )
+	{
+		munmap( const_cast<unsigned char*>( bytes ), length );
+	}
+}
+
+#endif
+
+Image::Image( const std::string& name, const unsigned char* data, const size_t size ) : path( name ), bytes( data ), length( size ), mapped( false )
+{
+	checkSize();
+}
+
+void
+Image::checkSize()
+{
+	if ( length < 2 )
+	{
+		throw std::runtime_error( path + " has no origin" );
+	}
+	if ( length > MEM_SIZE * 2 )
+	{
+		throw std::runtime_error( path + " is too large" );
+	}
+	if ( length % 2 )
+	{
+		throw std::runtime_error( path + " has an odd length" );
+	}
+}
+
+const std::string&
+Image::getPath() const
+{
+	return path;
+}
+
+unsigned short
+Image::getOrigin() const
+{
+	return bytes[0] << 8 | bytes[1];
+}
+
+size_t
+Image::getSize() const
+{
+	return length / 2 - 1;
+}
+
+void
+Image::copyTo( unsigned short* mem ) const
+{
+	const unsigned char* src = bytes + 2;
+	unsigned short* dst = mem + getOrigin();
+	const size_t count = getSize();
+	size_t i = 0;
+#if defined( __SSE2__ )
+	for ( ; i + 8 <= count; i += 8 )
+	{
+		const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i * 2 ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i ), _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) ) );
+	}
+#endif
+	for ( ; i < count; i++ )
+	{
+		dst[i] = src[i * 2] << 8 | src[i * 2 + 1];
+	}
+}
+
+const Image&
+ImageCache::get( const std::string& filePath )
+{
+	std::shared_ptr<Entry> entry;
+	{
+		std::lock_guard<std::mutex> guard( lock );
+		std::shared_ptr<Entry>& slot = entries[filePath];
+		if ( !slot )
+		{
+			slot.reset( new Entry() );
+		}
+		entry = slot;
+	}
+	std::call_once( entry->loaded, [&entry, &filePath]
+	{
+		try
+		{
+			entry->image.reset( new Image( filePath ) );
+		}
+		catch ( const std::exception& err )
+		{
+			entry->error = err.what();
+		}
+	} );
+	if ( !entry->image )
+	{
+		throw std::runtime_error( entry->error );
+	}
+	return *entry->image;
+}
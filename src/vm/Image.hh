@@ -0,0 +1,47 @@
+#ifndef IMAGE_HH
+#define IMAGE_HH
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Image
+{
+	public:
+		Image( const std::string& filePath );
+		Image( const std::string& name, const unsigned char* data, const size_t size );
+		~Image();
+		Image( const Image& ) = delete;
+		Image& operator=( const Image& ) = delete;
+		const std::string& getPath() const;
+		unsigned short getOrigin() const;
+		size_t getSize() const;
+		void copyTo( unsigned short* mem ) const;
+	private:
+		std::string path;
+		const unsigned char* bytes;
+		size_t length;
+		bool mapped;
+		std::vector<unsigned char> contents;
+		void checkSize();
+};
+
+class ImageCache
+{
+	public:
+		const Image& get( const std::string& filePath );
+	private:
+		struct Entry
+		{
+			std::once_flag loaded;
+			std::unique_ptr<Image> image;
+			std::string error;
+		};
+		std::mutex lock;
+		std::map<std::string, std::shared_ptr<Entry>> entries;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#include "Input.hh"
+#include <cstdio>
+
+StringInput::StringInput( const std::string& str ) : data( str ), pos( 0 ) { }
+
+bool
+StringInput::isReady()
+{
+	return true;
+}
+
+int
+StringInput::get()
+{
+	return pos < data.size() ? static_cast<unsigned char>( data[pos++] ) : EOF;
+}
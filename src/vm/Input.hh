@@ -0,0 +1,26 @@
+#ifndef INPUT_HH
+#define INPUT_HH
+
+#include <string>
+
+class Input
+{
+	public:
+		virtual ~Input() { }
+		virtual bool isReady() = 0;
+		virtual int get() = 0;
+		virtual void wait( const int ) { }
+};
+
+class StringInput : public Input
+{
+	public:
+		StringInput( const std::string& str );
+		bool isReady();
+		int get();
+	private:
+		std::string data;
+		std::string::size_type pos;
+};
+
+#endif
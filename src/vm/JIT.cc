@@ -0,0 +1,603 @@
+#include "JIT.hh"
+#include <cstring>
+#include <climits>
+
+#define WINDOWS __CYGWIN__ || _WIN32
+
+#if defined( __x86_64__ ) && !( WINDOWS )
+
+#include <sys/mman.h>
+
+enum
+{
+	DEVICE_BASE = 0xFE00,
+	CODE_SIZE = 16 << 20,
+	MAX_BLOCK = 64,
+	MAX_BLOCK_BYTES = MAX_BLOCK * 256
+};
+
+enum Register
+{
+	EAX,
+	ECX,
+	EDX
+};
+
+enum Condition
+{
+	JMP_ALWAYS = 0,
+	JAE = 0x83,
+	JE = 0x84,
+	JNE = 0x85
+};
+
+static_assert( sizeof( Decoded ) == 8, "cache entries are indexed with a scale of 8" );
+
+JIT::JIT( CPU& c ) : cpu( c ), used( 0 ), table(), codeMap()
+{
+	void* p = mmap( NULL, CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	code = p == MAP_FAILED ? NULL : static_cast<unsigned char*>( p );
+	if ( !code )
+	{
+		return;
+	}
+
+	char* base = reinterpret_cast<char*>( &cpu );
+	gprOff = reinterpret_cast<char*>( cpu.GPR ) - base;
+	pcOff = reinterpret_cast<char*>( &cpu.PC ) - base;
+	psrOff = reinterpret_cast<char*>( &cpu.PSR ) - base;
+	budgetOff = reinterpret_cast<char*>( &cpu.budget ) - base;
+	cacheOff = reinterpret_cast<char*>( cpu.cache ) - base + offsetof( Decoded, form );
+
+	enter = reinterpret_cast<Entry>( code );
+	emit( { 0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57 } );
+	emit( { 0x48, 0x83, 0xEC, 0x08 } );
+	emit( { 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4, 0x49, 0x89, 0xD5, 0x49, 0x89, 0xCE } );
+	emit( { 0x41, 0xFF, 0xE0 } );
+	exitStub = code + used;
+	emit( { 0x48, 0x83, 0xC4, 0x08 } );
+	emit( { 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B, 0xC3 } );
+	codeStart = used;
+}
+
+JIT::~JIT()
+{
+	if ( code )
+	{
+		munmap( code, CODE_SIZE );
+	}
+}
+
+bool
+JIT::isAvailable()
+{
+	return code != NULL;
+}
+
+void
+JIT::run( const unsigned long long limit )
+{
+	cpu.budget = limit > LLONG_MAX ? LLONG_MAX : limit;
+	const long long start = cpu.budget;
+	cpu.syncPSR();
+	while ( !cpu.halted && !cpu.waiting && cpu.budget > 0 )
+	{
+		void* entry = table[cpu.PC];
+		if ( !entry )
+		{
+			entry = compile( cpu.PC );
+		}
+		if ( entry )
+		{
+			enter( &cpu, cpu.mem.data(), table, codeMap, entry );
+		}
+		else
+		{
+			cpu.step();
+			cpu.syncPSR();
+			cpu.budget--;
+		}
+	}
+	cpu.instret += start - cpu.budget;
+}
+
+bool
+JIT::isTranslatable( const Decoded& d )
+{
+	return d.form != RTI_FORM && d.form != RES_FORM && d.form != TRAP_FORM;
+}
+
+void*
+JIT::compile( const unsigned short start )
+{
+	unsigned short* mem = cpu.mem.data();
+	if ( start >= DEVICE_BASE || !isTranslatable( cpu.decode( start, mem[start] ) ) )
+	{
+		return NULL;
+	}
+	if ( CODE_SIZE - used < MAX_BLOCK_BYTES )
+	{
+		flush();
+	}
+
+	void* entry = code + used;
+	unsigned short addr = start;
+	bool ccSet = false;
+	bool done = false;
+	for ( int n = 0; !done; n++ )
+	{
+		const Decoded d = cpu.decode( addr, mem[addr] );
+		if ( n == MAX_BLOCK || addr >= DEVICE_BASE || !isTranslatable( d ) )
+		{
+			if ( ccSet )
+			{
+				emitSyncPSR();
+			}
+			emitChain( addr, n );
+			break;
+		}
+		const unsigned short next = ++addr;
+		const unsigned int imm = static_cast<short>( d.val );
+		switch ( d.form )
+		{
+			case BR_FORM:
+			{
+				if ( ccSet )
+				{
+					emitSyncPSR();
+				}
+				if ( d.r0 == 7 )
+				{
+					emitChain( d.val, n + 1 );
+				}
+				else if ( d.r0 == 0 )
+				{
+					emitChain( next, n + 1 );
+				}
+				else
+				{
+					emit( { 0xF6, 0x83 } );
+					emit32( psrOff );
+					emit( { d.r0 } );
+					const size_t notTaken = emitJump( JE );
+					emitChain( d.val, n + 1 );
+					patchJump( notTaken );
+					emitChain( next, n + 1 );
+				}
+				done = true;
+				break;
+			}
+			case ADD_REG:
+			case AND_REG:
+			{
+				emitGetReg( EAX, d.r1 );
+				emitGetReg( ECX, d.r2 );
+				emit( { static_cast<unsigned char>( d.form == ADD_REG ? 0x01 : 0x21 ), 0xC8 } );
+				emitSetReg( d.r0 );
+				emitSetcc();
+				ccSet = true;
+				break;
+			}
+			case ADD_IMM:
+			case AND_IMM:
+			{
+				emitGetReg( EAX, d.r1 );
+				emit( { static_cast<unsigned char>( d.form == ADD_IMM ? 0x05 : 0x25 ) } );
+				emit32( imm );
+				emitSetReg( d.r0 );
+				emitSetcc();
+				ccSet = true;
+				break;
+			}
+			case NOT_FORM:
+			{
+				emitGetReg( EAX, d.r1 );
+				emit( { 0xF7, 0xD0 } );
+				emitSetReg( d.r0 );
+				emitSetcc();
+				ccSet = true;
+				break;
+			}
+			case LEA_FORM:
+			{
+				emitSetRegImm( d.r0, d.val );
+				emit( { 0x41, 0xBF } );
+				emit32( d.val );
+				ccSet = true;
+				break;
+			}
+			case LD_FORM:
+			case LDI_FORM:
+			{
+				emitLoadConst( d.val );
+				if ( d.form == LDI_FORM )
+				{
+					emit( { 0x89, 0xC1 } );
+					emitLoad();
+				}
+				emitSetReg( d.r0 );
+				emitSetcc();
+				ccSet = true;
+				break;
+			}
+			case LDR_FORM:
+			{
+				emitGetReg( ECX, d.r1 );
+				emit( { 0x81, 0xC1 } );
+				emit32( imm );
+				emit( { 0x0F, 0xB7, 0xC9 } );
+				emitLoad();
+				emitSetReg( d.r0 );
+				emitSetcc();
+				ccSet = true;
+				break;
+			}
+			case ST_FORM:
+			{
+				emit( { 0xB9 } );
+				emit32( d.val );
+				emitGetReg( EAX, d.r0 );
+				emitStore( next, ccSet, n + 1 );
+				break;
+			}
+			case STI_FORM:
+			{
+				emitLoadConst( d.val );
+				emit( { 0x89, 0xC1 } );
+				emitGetReg( EAX, d.r0 );
+				emitStore( next, ccSet, n + 1 );
+				break;
+			}
+			case STR_FORM:
+			{
+				emitGetReg( ECX, d.r1 );
+				emit( { 0x81, 0xC1 } );
+				emit32( imm );
+				emit( { 0x0F, 0xB7, 0xC9 } );
+				emitGetReg( EAX, d.r0 );
+				emitStore( next, ccSet, n + 1 );
+				break;
+			}
+			case JSR_FORM:
+			case JSRR_FORM:
+			case JMP_FORM:
+			{
+				if ( ccSet )
+				{
+					emitSyncPSR();
+				}
+				if ( d.form != JMP_FORM )
+				{
+					emitSetRegImm( 7, next );
+				}
+				if ( d.form == JSR_FORM )
+				{
+					emitChain( d.val, n + 1 );
+				}
+				else
+				{
+					emitGetReg( EAX, d.r1 );
+					emitChainIndirect( n + 1 );
+				}
+				done = true;
+				break;
+			}
+		}
+	}
+
+	blocks.push_back( { start, addr } );
+	for ( unsigned int i = start; i < addr; i++ )
+	{
+		codeMap[i] = 1;
+	}
+	table[start] = entry;
+	return entry;
+}
+
+void
+JIT::flush()
+{
+	used = codeStart;
+	std::memset( table, 0, sizeof table );
+	std::memset( codeMap, 0, sizeof codeMap );
+	blocks.clear();
+}
+
+void
+JIT::invalidate( const unsigned short addr )
+{
+	std::vector<Block> kept;
+	for ( const Block& b : blocks )
+	{
+		if ( addr >= b.start && addr < b.end )
+		{
+			table[b.start] = NULL;
+		}
+		else
+		{
+			kept.push_back( b );
+		}
+	}
+	blocks.swap( kept );
+	std::memset( codeMap, 0, sizeof codeMap );
+	for ( const Block& b : blocks )
+	{
+		std::memset( codeMap + b.start, 1, b.end - b.start );
+	}
+}
+
+unsigned short
+JIT::loadHelper( JIT* jit, unsigned int addr )
+{
+	return jit->cpu.mem.read( addr );
+}
+
+bool
+JIT::storeHelper( JIT* jit, unsigned int addr, unsigned int val )
+{
+	jit->cpu.store( addr, val );
+	if ( jit->codeMap[addr] )
+	{
+		jit->invalidate( addr );
+		return true;
+	}
+	return jit->cpu.halted;
+}
+
+void
+JIT::emit( std::initializer_list<unsigned char> bytes )
+{
+	for ( const unsigned char b : bytes )
+	{
+		code[used++] = b;
+	}
+}
+
+void
+JIT::emit16( const unsigned short val )
+{
+	std::memcpy( code + used, &val, sizeof val );
+	used += sizeof val;
+}
+
+void
+JIT::emit32( const unsigned int val )
+{
+	std::memcpy( code + used, &val, sizeof val );
+	used += sizeof val;
+}
+
+void
+JIT::emit64( const unsigned long long val )
+{
+	std::memcpy( code + used, &val, sizeof val );
+	used += sizeof val;
+}
+
+size_t
+JIT::emitJump( const unsigned char condition )
+{
+	if ( condition == JMP_ALWAYS )
+	{
+		emit( { 0xE9 } );
+	}
+	else
+	{
+		emit( { 0x0F, condition } );
+	}
+	emit32( 0 );
+	return used;
+}
+
+void
+JIT::patchJump( const size_t from )
+{
+	const unsigned int rel = used - from;
+	std::memcpy( code + from - 4, &rel, sizeof rel );
+}
+
+void
+JIT::emitGetReg( const int x86, const int reg )
+{
+	emit( { 0x0F, 0xB7, static_cast<unsigned char>( 0x83 | x86 << 3 ) } );
+	emit32( gprOff + 2 * reg );
+}
+
+void
+JIT::emitSetReg( const int reg )
+{
+	emit( { 0x66, 0x89, 0x83 } );
+	emit32( gprOff + 2 * reg );
+}
+
+void
+JIT::emitSetRegImm( const int reg, const unsigned short val )
+{
+	emit( { 0x66, 0xC7, 0x83 } );
+	emit32( gprOff + 2 * reg );
+	emit16( val );
+}
+
+void
+JIT::emitSetcc()
+{
+	emit( { 0x41, 0x89, 0xC7 } );
+}
+
+void
+JIT::emitSyncPSR()
+{
+	emit( { 0x0F, 0xB7, 0x83 } );
+	emit32( psrOff );
+	emit( { 0x25, 0xF8, 0xFF, 0x00, 0x00 } );
+	emit( { 0xB9, 0x02, 0x00, 0x00, 0x00 } );
+	emit( { 0x66, 0x45, 0x85, 0xFF } );
+	emit( { 0x74, 0x0C } );
+	emit( { 0xB9, 0x01, 0x00, 0x00, 0x00 } );
+	emit( { 0x79, 0x05 } );
+	emit( { 0xB9, 0x04, 0x00, 0x00, 0x00 } );
+	emit( { 0x09, 0xC8 } );
+	emit( { 0x66, 0x89, 0x83 } );
+	emit32( psrOff );
+}
+
+void
+JIT::emitCharge( const int count )
+{
+	emit( { 0x48, 0x81, 0xAB } );
+	emit32( budgetOff );
+	emit32( count );
+}
+
+void
+JIT::emitChain( const unsigned short target, const int count )
+{
+	emit( { 0x66, 0xC7, 0x83 } );
+	emit32( pcOff );
+	emit16( target );
+	emitCharge( count );
+	emit( { 0x0F, 0x8E } );
+	emit32( exitStub - ( code + used + 4 ) );
+	emit( { 0x49, 0x8B, 0x85 } );
+	emit32( target * 8 );
+	emit( { 0x48, 0x85, 0xC0, 0x0F, 0x84 } );
+	emit32( exitStub - ( code + used + 4 ) );
+	emit( { 0xFF, 0xE0 } );
+}
+
+void
+JIT::emitChainIndirect( const int count )
+{
+	emit( { 0x66, 0x89, 0x83 } );
+	emit32( pcOff );
+	emitCharge( count );
+	emit( { 0x0F, 0x8E } );
+	emit32( exitStub - ( code + used + 4 ) );
+	emit( { 0x49, 0x8B, 0x44, 0xC5, 0x00 } );
+	emit( { 0x48, 0x85, 0xC0, 0x0F, 0x84 } );
+	emit32( exitStub - ( code + used + 4 ) );
+	emit( { 0xFF, 0xE0 } );
+}
+
+void
+JIT::emitCall( void* fn )
+{
+	emit( { 0x48, 0xB8 } );
+	emit64( reinterpret_cast<unsigned long long>( fn ) );
+	emit( { 0xFF, 0xD0 } );
+}
+
+void
+JIT::emitLoad()
+{
+	emit( { 0x81, 0xF9 } );
+	emit32( DEVICE_BASE );
+	const size_t slow = emitJump( JAE );
+	emit( { 0x41, 0x0F, 0xB7, 0x04, 0x4C } );
+	const size_t done = emitJump( JMP_ALWAYS );
+	patchJump( slow );
+	emit( { 0x48, 0xBF } );
+	emit64( reinterpret_cast<unsigned long long>( this ) );
+	emit( { 0x89, 0xCE } );
+	emitCall( reinterpret_cast<void*>( &loadHelper ) );
+	patchJump( done );
+}
+
+void
+JIT::emitLoadConst( const unsigned short addr )
+{
+	if ( addr < DEVICE_BASE )
+	{
+		emit( { 0x41, 0x0F, 0xB7, 0x84, 0x24 } );
+		emit32( addr * 2 );
+		return;
+	}
+	emit( { 0x48, 0xBF } );
+	emit64( reinterpret_cast<unsigned long long>( this ) );
+	emit( { 0xBE } );
+	emit32( addr );
+	emitCall( reinterpret_cast<void*>( &loadHelper ) );
+}
+
+void
+JIT::emitStore( const unsigned short next, const bool ccSet, const int count )
+{
+	emit( { 0x81, 0xF9 } );
+	emit32( DEVICE_BASE );
+	const size_t device = emitJump( JAE );
+	emit( { 0x41, 0x80, 0x3C, 0x0E, 0x00 } );
+	const size_t translated = emitJump( JNE );
+	emit( { 0x66, 0x41, 0x89, 0x04, 0x4C } );
+	emit( { 0xC6, 0x84, 0xCB } );
+	emit32( cacheOff );
+	emit( { 0x00 } );
+	const size_t done = emitJump( JMP_ALWAYS );
+	patchJump( device );
+	patchJump( translated );
+	emit( { 0x48, 0xBF } );
+	emit64( reinterpret_cast<unsigned long long>( this ) );
+	emit( { 0x89, 0xCE, 0x89, 0xC2 } );
+	emitCall( reinterpret_cast<void*>( &storeHelper ) );
+	emit( { 0x84, 0xC0 } );
+	const size_t unchanged = emitJump( JE );
+	emitExit( next, ccSet, count );
+	patchJump( unchanged );
+	patchJump( done );
+}
+
+void
+JIT::emitExit( const unsigned short pc, const bool ccSet, const int count )
+{
+	if ( ccSet )
+	{
+		emitSyncPSR();
+	}
+	emit( { 0x66, 0xC7, 0x83 } );
+	emit32( pcOff );
+	emit16( pc );
+	emitCharge( count );
+	emit( { 0xE9 } );
+	emit32( exitStub - ( code + used + 4 ) );
+}
+
+void
+CPU::runJIT( const unsigned long long limit )
+{
+	if ( !jit )
+	{
+		jit = new JIT( *this );
+	}
+	if ( !jit->isAvailable() )
+	{
+		runThreaded( limit );
+		return;
+	}
+	jit->run( limit );
+}
+
+void
+CPU::discardJIT()
+{
+	delete jit;
+	jit = NULL;
+}
+
+CPU::~CPU()
+{
+	discardJIT();
+}
+
+#else
+
+void
+CPU::runJIT( const unsigned long long limit )
+{
+	runThreaded( limit );
+}
+
+void
+CPU::discardJIT() { }
+
+CPU::~CPU() { }
+
+#endif
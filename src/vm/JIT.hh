@@ -0,0 +1,57 @@
+#ifndef JIT_HH
+#define JIT_HH
+
+#include "CPU.hh"
+#include <cstddef>
+#include <vector>
+
+class JIT
+{
+	public:
+		JIT( CPU& cpu );
+		~JIT();
+		bool isAvailable();
+		void run( const unsigned long long limit );
+	private:
+		struct Block
+		{
+			unsigned short start, end;
+		};
+		typedef void ( *Entry )( CPU* cpu, unsigned short* mem, void** table, unsigned char* codeMap, void* code );
+		CPU& cpu;
+		unsigned char* code;
+		size_t used, codeStart;
+		Entry enter;
+		unsigned char* exitStub;
+		void* table[MEM_SIZE];
+		unsigned char codeMap[MEM_SIZE];
+		std::vector<Block> blocks;
+		long gprOff, pcOff, psrOff, budgetOff, cacheOff;
+		void* compile( const unsigned short start );
+		void flush();
+		void invalidate( const unsigned short addr );
+		bool isTranslatable( const Decoded& d );
+		void emit( std::initializer_list<unsigned char> bytes );
+		void emit16( const unsigned short val );
+		void emit32( const unsigned int val );
+		void emit64( const unsigned long long val );
+		size_t emitJump( const unsigned char opcode );
+		void patchJump( const size_t from );
+		void emitGetReg( const int x86, const int reg );
+		void emitSetReg( const int reg );
+		void emitSetRegImm( const int reg, const unsigned short val );
+		void emitSetcc();
+		void emitSyncPSR();
+		void emitChain( const unsigned short target, const int count );
+		void emitChainIndirect( const int count );
+		void emitCharge( const int count );
+		void emitLoad();
+		void emitLoadConst( const unsigned short addr );
+		void emitStore( const unsigned short next, const bool ccSet, const int count );
+		void emitCall( void* fn );
+		void emitExit( const unsigned short pc, const bool ccSet, const int count );
+		static unsigned short loadHelper( JIT* jit, unsigned int addr );
+		static bool storeHelper( JIT* jit, unsigned int addr, unsigned int val );
+};
+
+#endif
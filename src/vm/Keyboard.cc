@@ -0,0 +1,80 @@
+#include "Keyboard.hh"
+#include <chrono>
+#include <cstdio>
+
+Keyboard::Keyboard() : head( 0 ), tail( 0 ), closed( false )
+{
+	std::thread( &Keyboard::readLoop, this ).detach();
+}
+
+bool
+Keyboard::isReady()
+{
+	return tail.load( std::memory_order_relaxed ) != head.load( std::memory_order_acquire )
+		|| closed.load( std::memory_order_acquire );
+}
+
+int
+Keyboard::get()
+{
+	if ( !isReady() )
+	{
+		std::unique_lock<std::mutex> guard( lock );
+		changed.wait( guard, [this] { return isReady(); } );
+	}
+	const unsigned int t = tail.load( std::memory_order_relaxed );
+	const unsigned int h = head.load( std::memory_order_acquire );
+	if ( t == h )
+	{
+		return EOF;
+	}
+	const unsigned char c = buffer[t % BUFFER_SIZE];
+	tail.store( t + 1, std::memory_order_release );
+	if ( h - t == BUFFER_SIZE )
+	{
+		{
+			std::lock_guard<std::mutex> guard( lock );
+		}
+		changed.notify_all();
+	}
+	return c;
+}
+
+void
+Keyboard::wait( const int timeoutMs )
+{
+	std::unique_lock<std::mutex> guard( lock );
+	changed.wait_for( guard, std::chrono::milliseconds( timeoutMs ), [this] { return isReady(); } );
+}
+
+void
+Keyboard::push( const unsigned char c )
+{
+	const unsigned int h = head.load( std::memory_order_relaxed );
+	if ( h - tail.load( std::memory_order_acquire ) == BUFFER_SIZE )
+	{
+		std::unique_lock<std::mutex> guard( lock );
+		changed.wait( guard, [this, h] { return h - tail.load( std::memory_order_acquire ) < BUFFER_SIZE; } );
+	}
+	buffer[h % BUFFER_SIZE] = c;
+	{
+		std::lock_guard<std::mutex> guard( lock );
+		head.store( h + 1, std::memory_order_release );
+	}
+	changed.notify_all();
+}
+
+void
+Keyboard::readLoop()
+{
+	int c;
+	while ( ( c = std::getchar() ) != EOF )
+	{
+		push( c );
+	}
+	{
+		std::lock_guard<std::mutex> guard( lock );
+		closed.store( true, std::memory_order_release );
+	}
+	changed.notify_all();
+}
@@ -0,0 +1,31 @@
+#ifndef KEYBOARD_HH
+#define KEYBOARD_HH
+
+#include "Input.hh"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class Keyboard : public Input
+{
+	public:
+		Keyboard();
+		bool isReady();
+		int get();
+		void wait( const int timeoutMs );
+	private:
+		enum
+		{
+			BUFFER_SIZE = 4096
+		};
+		unsigned char buffer[BUFFER_SIZE];
+		std::atomic<unsigned int> head, tail;
+		std::atomic<bool> closed;
+		std::mutex lock;
+		std::condition_variable changed;
+		void readLoop();
+		void push( const unsigned char c );
+};
+
+#endif
@@ -0,0 +1,423 @@
+#include "Lockstep.hh"
+#include <stdexcept>
+
+enum
+{
+	P = 1,
+	Z = 2,
+	N = 4,
+	EXPLICIT = 0x8,
+	KBSR = 0xFE00,
+	QUOTA = 1 << 30
+};
+
+enum Opcode
+{
+	BR,
+	ADD,
+	LD,
+	ST,
+	JSR,
+	AND,
+	LDR,
+	STR,
+	RTI,
+	NOT,
+	LDI,
+	STI,
+	JMP,
+	RES,
+	LEA,
+	TRAP
+};
+
+Lockstep::Lockstep() : cpus(), memory(), count( 0 ), GPR(), PC(), result(), live(), flags(), mask(), value(), counts(), executed(), decoded( MEM_SIZE ), written( MEM_SIZE ) { }
+
+size_t
+Lockstep::add( CPU& cpu )
+{
+	if ( count == LANES )
+	{
+		throw std::runtime_error( "All " + std::to_string( LANES ) + " lanes are in use" );
+	}
+	cpus[count] = &cpu;
+	memory[count] = cpu.mem.data();
+	return count++;
+}
+
+const std::string&
+Lockstep::getError( const size_t lane )
+{
+	return errors[lane];
+}
+
+void
+Lockstep::run( const unsigned long long limit )
+{
+	for ( size_t l = 0; l < count; l++ )
+	{
+		CPU& cpu = *cpus[l];
+		cpu.discardJIT();
+		for ( int r = 0; r < GPR_COUNT; r++ )
+		{
+			GPR[r][l] = cpu.GPR[r];
+		}
+		PC[l] = cpu.PC;
+		readFlags( l );
+		executed[l] = 0;
+		live[l] = !cpu.halted && limit > 0 ? 0xFFFF : 0;
+	}
+	while ( true )
+	{
+		bool running = false;
+		unsigned long long quota = QUOTA;
+		for ( size_t l = 0; l < count; l++ )
+		{
+			if ( live[l] )
+			{
+				running = true;
+				quota = limit - executed[l] < quota ? limit - executed[l] : quota;
+			}
+		}
+		if ( !running )
+		{
+			break;
+		}
+		for ( unsigned long long i = 0; i < quota && stepGroup(); i++ );
+		for ( size_t l = 0; l < count; l++ )
+		{
+			executed[l] += counts[l];
+			counts[l] = 0;
+			if ( executed[l] >= limit )
+			{
+				live[l] = 0;
+			}
+		}
+	}
+	for ( size_t l = 0; l < count; l++ )
+	{
+		CPU& cpu = *cpus[l];
+		for ( int r = 0; r < GPR_COUNT; r++ )
+		{
+			cpu.GPR[r] = GPR[r][l];
+		}
+		cpu.PC = PC[l];
+		writeFlags( l );
+		cpu.syncPSR();
+		cpu.instret += executed[l];
+	}
+}
+
+bool
+Lockstep::stepGroup()
+{
+	unsigned short next = 0xFFFF;
+	for ( int l = 0; l < LANES; l++ )
+	{
+		const unsigned short pc = PC[l] | ~live[l];
+		next = pc < next ? pc : next;
+	}
+	unsigned short any = 0;
+	for ( int l = 0; l < LANES; l++ )
+	{
+		mask[l] = live[l] & -( PC[l] == next );
+		any |= mask[l];
+	}
+	if ( !any )
+	{
+		return false;
+	}
+	size_t leader = 0;
+	while ( !mask[leader] )
+	{
+		leader++;
+	}
+	const unsigned short instr = memory[leader][next];
+	if ( next >= KBSR )
+	{
+		stepLanes();
+	}
+	else if ( written[next] )
+	{
+		for ( size_t l = leader + 1; l < count; l++ )
+		{
+			mask[l] &= -( memory[l][next] == instr );
+		}
+		execute( cpus[leader]->decode( next, instr ) );
+	}
+	else
+	{
+		Decoded& d = decoded[next];
+		if ( !d.form )
+		{
+			d = cpus[leader]->decode( next, instr );
+		}
+		execute( d );
+	}
+	for ( int l = 0; l < LANES; l++ )
+	{
+		counts[l] += mask[l] & 1;
+	}
+	return true;
+}
+
+void
+Lockstep::execute( const Decoded& d )
+{
+	const int r0 = d.r0, r1 = d.r1, r2 = d.r2;
+	const unsigned short val = d.val, imm = -d.imm;
+	switch ( d.opcode )
+	{
+		case BR:
+		{
+			const unsigned short n = -( ( r0 & N ) != 0 ), z = -( ( r0 & Z ) != 0 ), p = -( ( r0 & P ) != 0 );
+			for ( int l = 0; l < LANES; l++ )
+			{
+				const unsigned short negative = -( result[l] >> 15 );
+				const unsigned short zero = -( result[l] == 0 );
+				const unsigned short derived = ( negative & n ) | ( zero & z ) | ( ~( negative | zero ) & p );
+				const unsigned short fixed = -( flags[l] >> 3 );
+				const unsigned short taken = ( derived & ~fixed ) | ( -( ( flags[l] & r0 ) != 0 ) & fixed );
+				value[l] = ( val & taken ) | ( ( PC[l] + 1 ) & ~taken );
+			}
+			jump();
+			return;
+		}
+		case ADD:
+		case AND:
+		{
+			if ( d.opcode == ADD && d.imm )
+			{
+				for ( int l = 0; l < LANES; l++ )
+				{
+					value[l] = GPR[r1][l] + val;
+				}
+			}
+			else if ( d.opcode == ADD )
+			{
+				for ( int l = 0; l < LANES; l++ )
+				{
+					value[l] = GPR[r1][l] + GPR[r2][l];
+				}
+			}
+			else if ( d.imm )
+			{
+				for ( int l = 0; l < LANES; l++ )
+				{
+					value[l] = GPR[r1][l] & val;
+				}
+			}
+			else
+			{
+				for ( int l = 0; l < LANES; l++ )
+				{
+					value[l] = GPR[r1][l] & GPR[r2][l];
+				}
+			}
+			assign( r0 );
+			break;
+		}
+		case NOT:
+		{
+			for ( int l = 0; l < LANES; l++ )
+			{
+				value[l] = ~GPR[r1][l];
+			}
+			assign( r0 );
+			break;
+		}
+		case LEA:
+		{
+			for ( int l = 0; l < LANES; l++ )
+			{
+				value[l] = val;
+			}
+			assign( r0 );
+			break;
+		}
+		case JSR:
+		{
+			for ( int l = 0; l < LANES; l++ )
+			{
+				GPR[7][l] = ( GPR[7][l] & ~mask[l] ) | ( ( PC[l] + 1 ) & mask[l] );
+			}
+			for ( int l = 0; l < LANES; l++ )
+			{
+				value[l] = ( val & imm ) | ( GPR[r1][l] & ~imm );
+			}
+			jump();
+			return;
+		}
+		case JMP:
+		{
+			for ( int l = 0; l < LANES; l++ )
+			{
+				value[l] = GPR[r1][l];
+			}
+			jump();
+			return;
+		}
+		case LD:
+		case LDR:
+		case LDI:
+		{
+			load( d );
+			return;
+		}
+		case ST:
+		case STR:
+		case STI:
+		{
+			store( d );
+			return;
+		}
+		default:
+		{
+			stepLanes();
+			return;
+		}
+	}
+	for ( int l = 0; l < LANES; l++ )
+	{
+		PC[l] += mask[l] & 1;
+	}
+}
+
+void
+Lockstep::assign( const int reg )
+{
+	for ( int l = 0; l < LANES; l++ )
+	{
+		GPR[reg][l] = ( GPR[reg][l] & ~mask[l] ) | ( value[l] & mask[l] );
+		result[l] = ( result[l] & ~mask[l] ) | ( value[l] & mask[l] );
+		flags[l] &= ~mask[l];
+	}
+}
+
+void
+Lockstep::jump()
+{
+	for ( int l = 0; l < LANES; l++ )
+	{
+		PC[l] = ( PC[l] & ~mask[l] ) | ( value[l] & mask[l] );
+	}
+}
+
+void
+Lockstep::load( const Decoded& d )
+{
+	for ( size_t l = 0; l < count; l++ )
+	{
+		if ( !mask[l] )
+		{
+			continue;
+		}
+		Memory& mem = cpus[l]->mem;
+		unsigned short addr = d.opcode == LDR ? GPR[d.r1][l] + d.val : d.val;
+		if ( d.opcode == LDI )
+		{
+			addr = addr < KBSR ? memory[l][addr] : mem.read( addr );
+		}
+		GPR[d.r0][l] = addr < KBSR ? memory[l][addr] : mem.read( addr );
+		result[l] = GPR[d.r0][l];
+		flags[l] = 0;
+		PC[l]++;
+	}
+}
+
+void
+Lockstep::store( const Decoded& d )
+{
+	for ( size_t l = 0; l < count; l++ )
+	{
+		if ( !mask[l] )
+		{
+			continue;
+		}
+		CPU& cpu = *cpus[l];
+		unsigned short addr = d.opcode == STR ? GPR[d.r1][l] + d.val : d.val;
+		if ( d.opcode == STI )
+		{
+			addr = addr < KBSR ? memory[l][addr] : cpu.mem.read( addr );
+		}
+		if ( addr < KBSR )
+		{
+			memory[l][addr] = GPR[d.r0][l];
+			cpu.cache[addr].form = UNDECODED;
+		}
+		else
+		{
+			cpu.store( addr, GPR[d.r0][l] );
+		}
+		if ( !written[addr] )
+		{
+			decoded[addr].form = UNDECODED;
+			written[addr] = true;
+		}
+		PC[l]++;
+		if ( cpu.halted )
+		{
+			live[l] = 0;
+		}
+	}
+}
+
+void
+Lockstep::stepLanes()
+{
+	for ( size_t l = 0; l < count; l++ )
+	{
+		if ( mask[l] )
+		{
+			stepLane( l );
+		}
+	}
+}
+
+void
+Lockstep::stepLane( const size_t lane )
+{
+	CPU& cpu = *cpus[lane];
+	for ( int r = 0; r < GPR_COUNT; r++ )
+	{
+		cpu.GPR[r] = GPR[r][lane];
+	}
+	cpu.PC = PC[lane];
+	writeFlags( lane );
+	try
+	{
+		cpu.step();
+	}
+	catch ( const std::exception& err )
+	{
+		errors[lane] = err.what();
+		live[lane] = 0;
+		mask[lane] = 0;
+	}
+	for ( int r = 0; r < GPR_COUNT; r++ )
+	{
+		GPR[r][lane] = cpu.GPR[r];
+	}
+	PC[lane] = cpu.PC;
+	readFlags( lane );
+	if ( cpu.halted )
+	{
+		live[lane] = 0;
+	}
+}
+
+void
+Lockstep::readFlags( const size_t lane )
+{
+	const CPU& cpu = *cpus[lane];
+	result[lane] = cpu.ccResult;
+	flags[lane] = cpu.ccLazy ? 0 : EXPLICIT | ( cpu.PSR & 0x7 );
+}
+
+void
+Lockstep::writeFlags( const size_t lane )
+{
+	CPU& cpu = *cpus[lane];
+	cpu.ccLazy = !flags[lane];
+	cpu.ccResult = result[lane];
+}
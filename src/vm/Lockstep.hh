@@ -0,0 +1,47 @@
+#ifndef LOCKSTEP_HH
+#define LOCKSTEP_HH
+
+#include "CPU.hh"
+#include <string>
+#include <vector>
+
+class Lockstep
+{
+	public:
+		enum
+		{
+			LANES = 16
+		};
+		Lockstep();
+		size_t add( CPU& cpu );
+		void run( const unsigned long long limit );
+		const std::string& getError( const size_t lane );
+	private:
+		CPU* cpus[LANES];
+		unsigned short* memory[LANES];
+		size_t count;
+		unsigned short GPR[GPR_COUNT][LANES];
+		unsigned short PC[LANES];
+		unsigned short result[LANES];
+		unsigned short live[LANES];
+		unsigned short flags[LANES];
+		unsigned short mask[LANES];
+		unsigned short value[LANES];
+		unsigned int counts[LANES];
+		unsigned long long executed[LANES];
+		std::string errors[LANES];
+		std::vector<Decoded> decoded;
+		std::vector<bool> written;
+		bool stepGroup();
+		void execute( const Decoded& d );
+		void assign( const int reg );
+		void jump();
+		void load( const Decoded& d );
+		void store( const Decoded& d );
+		void stepLane( const size_t lane );
+		void stepLanes();
+		void readFlags( const size_t lane );
+		void writeFlags( const size_t lane );
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "Monitor.hh"
+#include "platform.hh"
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if !( WINDOWS )
+
+#include <signal.h>
+#include <sys/stat.h>
+
+#endif
+
+static const char MAGIC[4] = { 'L', 'C', '3', 'M' };
+
+enum
+{
+	VERSION = 1
+};
+
+Monitor::Monitor( const std::string& n, const bool create ) : name( n[0] == '/' ? n : "/" + n ), owner( create ), fd( -1 ), counters( NULL ), retired( 0 )
+{
+#if WINDOWS
+	throw std::runtime_error( "Monitoring is not supported on Windows" );
+#else
+	fd = create ? shm_open( name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644 ) : shm_open( name.c_str(), O_RDONLY, 0 );
+	if ( fd < 0 )
+	{
+		throw std::runtime_error( "Can not open: " + name );
+	}
+	if ( create && ftruncate( fd, sizeof( Counters ) ) != 0 )
+	{
+		close( fd );
+		shm_unlink( name.c_str() );
+		throw std::runtime_error( "Can not size: " + name );
+	}
+	struct stat st;
+	if ( !create && ( fstat( fd, &st ) != 0 || static_cast<size_t>( st.st_size ) < sizeof( Counters ) ) )
+	{
+		close( fd );
+		throw std::runtime_error( "Not a monitor: " + name );
+	}
+	void* p = mmap( NULL, sizeof( Counters ), create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0 );
+	if ( p == MAP_FAILED )
+	{
+		close( fd );
+		if ( create )
+		{
+			shm_unlink( name.c_str() );
+		}
+		throw std::runtime_error( "Can not map: " + name );
+	}
+	if ( create )
+	{
+		counters = new ( p ) Counters();
+		std::memcpy( counters->magic, MAGIC, sizeof( MAGIC ) );
+		counters->version = VERSION;
+		counters->pid = getpid();
+	}
+	else
+	{
+		counters = static_cast<Counters*>( p );
+		if ( std::memcmp( counters->magic, MAGIC, sizeof( MAGIC ) ) != 0 || counters->version != VERSION )
+		{
+			munmap( p, sizeof( Counters ) );
+			close( fd );
+			throw std::runtime_error( "Not a monitor: " + name );
+		}
+	}
+#endif
+}
+
+Monitor::~Monitor()
+{
+#if !( WINDOWS )
+	munmap( counters, sizeof( Counters ) );
+	close( fd );
+	if ( owner )
+	{
+		shm_unlink( name.c_str() );
+	}
+#endif
+}
+
+const Monitor::Counters&
+Monitor::get()
+{
+	return *counters;
+}
+
+bool
+Monitor::isAlive()
+{
+#if WINDOWS
+	return false;
+#else
+	return kill( counters->pid, 0 ) == 0 || errno != ESRCH;
+#endif
+}
+
+void
+Monitor::setState( const State state )
+{
+	counters->state.store( state, std::memory_order_release );
+}
@@ -0,0 +1,62 @@
+#ifndef MONITOR_HH
+#define MONITOR_HH
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+class Monitor
+{
+	public:
+		enum State
+		{
+			STARTING,
+			RUNNING,
+			HALTED,
+			STOPPED
+		};
+		struct Counters
+		{
+			char magic[4];
+			unsigned int version;
+			long long pid;
+			std::atomic<unsigned int> state;
+			std::atomic<unsigned int> pc;
+			std::atomic<unsigned long long> instret;
+			std::atomic<unsigned long long> kbsrPolls;
+			std::atomic<unsigned long long> bytesOutput;
+			std::atomic<unsigned long long> opcodes[16];
+			std::atomic<unsigned long long> traps[256];
+		};
+		Monitor( const std::string& name, const bool create );
+		~Monitor();
+		const Counters& get();
+		bool isAlive();
+		void setState( const State state );
+		void countOpcode( const unsigned short instr ) { add( counters->opcodes[instr >> 12] ); }
+		void countTrap( const unsigned short vector ) { add( counters->traps[vector & 0xFF] ); }
+		void countPoll() { add( counters->kbsrPolls ); }
+		bool retire() { return !( ++retired & PUBLISH_MASK ); }
+		void publish( const unsigned short pc, const unsigned long long bytes );
+	private:
+		enum
+		{
+			PUBLISH_MASK = 0xFFF
+		};
+		std::string name;
+		bool owner;
+		int fd;
+		Counters* counters;
+		unsigned long long retired;
+		static void add( std::atomic<unsigned long long>& counter ) { counter.store( counter.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed ); }
+};
+
+inline void
+Monitor::publish( const unsigned short pc, const unsigned long long bytes )
+{
+	counters->pc.store( pc, std::memory_order_relaxed );
+	counters->bytesOutput.store( bytes, std::memory_order_relaxed );
+	counters->instret.store( retired, std::memory_order_relaxed );
+}
+
+#endif
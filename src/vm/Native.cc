@@ -0,0 +1,86 @@
+#include "Native.hh"
+#include "Keyboard.hh"
+#include "Console.hh"
+#include "Image.hh"
+#include "platform.hh"
+#include <memory>
+#include <signal.h>
+
+enum Opcode
+{
+	ST = 3,
+	STR = 7,
+	STI = 11
+};
+
+Native::Native( CPU& c, const Program& p ) : cpu( c ), program( p ), code( MEM_SIZE ), patched( false )
+{
+	for ( size_t i = 0; i < program.blockCount; i++ )
+	{
+		for ( unsigned int addr = program.blocks[i][0]; addr < program.blocks[i][1]; addr++ )
+		{
+			code[addr] = COMPILED;
+		}
+		code[program.blocks[i][0]] |= ENTRY;
+	}
+}
+
+int
+Native::main( const Program& program )
+{
+	signal( SIGINT, handleInterrupt );
+	disableBuffering();
+	// The reader thread stays blocked on stdin until exit, so the keyboard is never freed.
+	Input* input = new Keyboard();
+	Console console( stdout, true );
+	CPU cpu( *input, console );
+	std::vector<std::unique_ptr<Image>> owned;
+	std::vector<const Image*> images;
+	for ( size_t i = 0; i < program.segmentCount; i++ )
+	{
+		const Segment& s = program.segments[i];
+		owned.emplace_back( new Image( s.name, s.data, s.size ) );
+		images.push_back( owned.back().get() );
+	}
+	cpu.loadImages( images );
+	Native native( cpu, program );
+	native.run();
+	restoreBuffering();
+	return 0;
+}
+
+void
+Native::run()
+{
+	program.run( *this );
+	if ( !cpu.halted )
+	{
+		cpu.run( THREADED_ENGINE );
+	}
+}
+
+unsigned short
+Native::trap( const unsigned short next, const unsigned short vector )
+{
+	cpu.PC = next;
+	cpu.handleTrap( vector );
+	return cpu.PC;
+}
+
+unsigned short
+Native::interpret( const unsigned short addr )
+{
+	cpu.PC = addr;
+	do
+	{
+		const Decoded d = cpu.decode( cpu.PC, cpu.mem.data()[cpu.PC] );
+		if ( d.opcode == ST || d.opcode == STR || d.opcode == STI )
+		{
+			const unsigned short target = d.opcode == ST ? d.val : d.opcode == STR ? cpu.GPR[d.r1] + d.val : d.val < KBSR ? cpu.mem.data()[d.val] : 0;
+			patched = patched || code[target] || ( d.opcode == STI && d.val >= KBSR );
+		}
+		cpu.step();
+	}
+	while ( !cpu.halted && !patched && !( code[cpu.PC] & ENTRY ) );
+	return cpu.PC;
+}
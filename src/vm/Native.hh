@@ -0,0 +1,82 @@
+#ifndef NATIVE_HH
+#define NATIVE_HH
+
+#include "CPU.hh"
+#include <cstddef>
+#include <vector>
+
+class Native
+{
+	public:
+		struct Segment
+		{
+			const char* name;
+			const unsigned char* data;
+			size_t size;
+		};
+		struct Program
+		{
+			const Segment* segments;
+			size_t segmentCount;
+			const unsigned short ( *blocks )[2];
+			size_t blockCount;
+			void ( *run )( Native& vm );
+		};
+		Native( CPU& c, const Program& p );
+		static int main( const Program& program );
+		void run();
+		unsigned short* registers() { return cpu.GPR; }
+		unsigned short* memory() { return cpu.mem.data(); }
+		unsigned short getPC() { return cpu.PC; }
+		void setPC( const unsigned short addr ) { cpu.PC = addr; }
+		bool isStopped() { return cpu.halted || patched; }
+		unsigned short read( const unsigned short addr ) { return addr < KBSR ? cpu.mem.data()[addr] : cpu.mem.read( addr ); }
+		bool write( const unsigned short addr, const unsigned short val );
+		void setcc( const unsigned short val ) { cpu.ccResult = val; cpu.ccLazy = true; }
+		bool test( const unsigned short nzp );
+		unsigned short trap( const unsigned short next, const unsigned short vector );
+		unsigned short interpret( const unsigned short addr );
+	private:
+		enum
+		{
+			P = 1,
+			Z = 2,
+			N = 4,
+			KBSR = 0xFE00,
+			COMPILED = 1,
+			ENTRY = 2
+		};
+		CPU& cpu;
+		const Program& program;
+		std::vector<unsigned char> code;
+		bool patched;
+};
+
+inline bool
+Native::write( const unsigned short addr, const unsigned short val )
+{
+	if ( addr >= KBSR )
+	{
+		cpu.store( addr, val );
+		return cpu.halted;
+	}
+	cpu.mem.data()[addr] = val;
+	cpu.cache[addr].form = UNDECODED;
+	if ( code[addr] )
+	{
+		patched = true;
+	}
+	return patched;
+}
+
+inline bool
+Native::test( const unsigned short nzp )
+{
+	if ( !cpu.ccLazy )
+	{
+		return cpu.PSR & nzp;
+	}
+	return ( cpu.ccResult & 0x8000 ? N : cpu.ccResult ? P : Z ) & nzp;
+}
+
+#endif
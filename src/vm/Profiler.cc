@@ -0,0 +1,187 @@
+#include "Profiler.hh"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+static const char* const opcodeNames[] =
+{
+	"BR", "ADD", "LD", "ST", "JSR", "AND", "LDR", "STR",
+	"RTI", "NOT", "LDI", "STI", "JMP", "RES", "LEA", "TRAP"
+};
+
+static const char* const trapNames[] =
+{
+	"GETC", "OUT", "PUTS", "IN", "PUTSP", "HALT"
+};
+
+enum
+{
+	FIRST_TRAP = 0x20
+};
+
+static std::string
+hex( const unsigned int val )
+{
+	std::ostringstream s;
+	s << 'x' << std::hex << std::uppercase << std::setfill( '0' ) << std::setw( 4 ) << val;
+	return s.str();
+}
+
+Profiler::Profiler() : total( 0 ), addresses(), opcodes(), traps() { }
+
+void
+Profiler::record( const unsigned short addr, const unsigned short instr )
+{
+	total++;
+	addresses[addr]++;
+	opcodes[instr >> 12]++;
+}
+
+void
+Profiler::recordTrap( const unsigned short vector )
+{
+	traps[vector & 0xFF]++;
+}
+
+void
+Profiler::loadSymbols( const std::string& filePath )
+{
+	std::ifstream f( filePath );
+	std::string line;
+	while ( std::getline( f, line ) )
+	{
+		std::istringstream tokens( line );
+		std::string slashes, name, addr;
+		if ( !( tokens >> slashes >> name >> addr ) || slashes != "//" || addr.find_first_not_of( "0123456789abcdefABCDEF" ) != std::string::npos )
+		{
+			continue;
+		}
+		symbols.insert( std::make_pair( static_cast<unsigned short>( std::stoul( addr, NULL, 16 ) ), name ) );
+	}
+}
+
+std::string
+Profiler::label( const unsigned short addr )
+{
+	std::map<unsigned short, std::string>::iterator it = symbols.upper_bound( addr );
+	if ( it == symbols.begin() )
+	{
+		return "";
+	}
+	--it;
+	return addr == it->first ? it->second : it->second + "+" + std::to_string( addr - it->first );
+}
+
+std::string
+Profiler::percent( const unsigned long long count )
+{
+	std::ostringstream s;
+	s << std::fixed << std::setprecision( 2 ) << ( total ? 100.0 * count / total : 0.0 ) << '%';
+	return s.str();
+}
+
+void
+Profiler::report( std::ostream& out )
+{
+	out << "instructions: " << total << "\n\n";
+	reportAddresses( out );
+	reportRanges( out );
+	reportOpcodes( out );
+	reportTraps( out );
+}
+
+void
+Profiler::reportAddresses( std::ostream& out )
+{
+	std::vector<unsigned int> hot;
+	for ( unsigned int addr = 0; addr < MEM_SIZE; addr++ )
+	{
+		if ( addresses[addr] )
+		{
+			hot.push_back( addr );
+		}
+	}
+	const size_t n = std::min<size_t>( hot.size(), TOP_COUNT );
+	std::partial_sort( hot.begin(), hot.begin() + n, hot.end(), [this]( unsigned int a, unsigned int b )
+	{
+		return addresses[a] > addresses[b] || ( addresses[a] == addresses[b] && a < b );
+	} );
+	out << "hottest addresses:\n";
+	for ( size_t i = 0; i < n; i++ )
+	{
+		out << "  " << hex( hot[i] ) << std::setw( 16 ) << addresses[hot[i]] << std::setw( 9 ) << percent( addresses[hot[i]] ) << "  " << label( hot[i] ) << '\n';
+	}
+	out << '\n';
+}
+
+void
+Profiler::reportRanges( std::ostream& out )
+{
+	std::vector<Range> ranges;
+	for ( unsigned int addr = 0; addr < MEM_SIZE; addr++ )
+	{
+		if ( !addresses[addr] )
+		{
+			continue;
+		}
+		std::map<unsigned short, std::string>::iterator next = symbols.upper_bound( addr );
+		unsigned int start = addr & ~( BLOCK_SIZE - 1 );
+		unsigned int end = start + BLOCK_SIZE - 1;
+		if ( next != symbols.begin() )
+		{
+			start = std::prev( next )->first;
+			end = next == symbols.end() ? MEM_SIZE - 1 : next->first - 1;
+		}
+		else if ( next != symbols.end() && next->first <= end )
+		{
+			end = next->first - 1;
+		}
+		if ( ranges.empty() || ranges.back().start != start )
+		{
+			Range range = { static_cast<unsigned short>( start ), static_cast<unsigned short>( end ), 0 };
+			ranges.push_back( range );
+		}
+		ranges.back().count += addresses[addr];
+	}
+	const size_t n = std::min<size_t>( ranges.size(), TOP_COUNT );
+	std::partial_sort( ranges.begin(), ranges.begin() + n, ranges.end(), []( const Range& a, const Range& b )
+	{
+		return a.count > b.count || ( a.count == b.count && a.start < b.start );
+	} );
+	out << "hottest ranges:\n";
+	for ( size_t i = 0; i < n; i++ )
+	{
+		out << "  " << hex( ranges[i].start ) << '-' << hex( ranges[i].end ) << std::setw( 10 ) << ranges[i].count << std::setw( 9 ) << percent( ranges[i].count ) << "  " << label( ranges[i].start ) << '\n';
+	}
+	out << '\n';
+}
+
+void
+Profiler::reportOpcodes( std::ostream& out )
+{
+	out << "opcode mix:\n";
+	for ( int op = 0; op < 16; op++ )
+	{
+		if ( opcodes[op] )
+		{
+			out << "  " << std::left << std::setw( 5 ) << opcodeNames[op] << std::right << std::setw( 16 ) << opcodes[op] << std::setw( 9 ) << percent( opcodes[op] ) << '\n';
+		}
+	}
+	out << '\n';
+}
+
+void
+Profiler::reportTraps( std::ostream& out )
+{
+	out << "trap vectors:\n";
+	for ( int vector = 0; vector < 256; vector++ )
+	{
+		if ( traps[vector] )
+		{
+			const bool named = vector >= FIRST_TRAP && vector < FIRST_TRAP + 6;
+			out << "  " << std::left << std::setw( 5 ) << ( named ? std::string( trapNames[vector - FIRST_TRAP] ) : hex( vector ) ) << std::right << std::setw( 16 ) << traps[vector] << '\n';
+		}
+	}
+}
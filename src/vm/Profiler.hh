@@ -0,0 +1,41 @@
+#ifndef PROFILER_HH
+#define PROFILER_HH
+
+#include "CPU.hh"
+#include <map>
+#include <ostream>
+#include <string>
+
+class Profiler
+{
+	public:
+		Profiler();
+		void record( const unsigned short addr, const unsigned short instr );
+		void recordTrap( const unsigned short vector );
+		void loadSymbols( const std::string& filePath );
+		void report( std::ostream& out );
+	private:
+		enum
+		{
+			TOP_COUNT = 20,
+			BLOCK_SIZE = 32
+		};
+		struct Range
+		{
+			unsigned short start, end;
+			unsigned long long count;
+		};
+		unsigned long long total;
+		unsigned long long addresses[MEM_SIZE];
+		unsigned long long opcodes[16];
+		unsigned long long traps[256];
+		std::map<unsigned short, std::string> symbols;
+		std::string label( const unsigned short addr );
+		std::string percent( const unsigned long long count );
+		void reportAddresses( std::ostream& out );
+		void reportRanges( std::ostream& out );
+		void reportOpcodes( std::ostream& out );
+		void reportTraps( std::ostream& out );
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "Replay.hh"
+#include <cstdio>
+#include <stdexcept>
+
+Recorder::Recorder( Input& in, const char* filePath ) : input( in ), cpu( NULL ), log( filePath ), ended( false )
+{
+	if ( !log.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + std::string( filePath ) );
+	}
+}
+
+void
+Recorder::attach( CPU& c )
+{
+	cpu = &c;
+}
+
+bool
+Recorder::isReady()
+{
+	return input.isReady();
+}
+
+int
+Recorder::get()
+{
+	const int c = input.get();
+	if ( !ended )
+	{
+		log << cpu->getInstructionCount() << ' ' << c << std::endl;
+		ended = c == EOF;
+	}
+	return c;
+}
+
+void
+Recorder::wait( const int timeoutMs )
+{
+	input.wait( timeoutMs );
+}
+
+Replayer::Replayer( const char* filePath ) : cpu( NULL ), next( 0 )
+{
+	std::ifstream f( filePath );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + std::string( filePath ) );
+	}
+	Event e;
+	while ( f >> e.instruction >> e.value )
+	{
+		events.push_back( e );
+	}
+	if ( !f.eof() )
+	{
+		throw std::runtime_error( std::string( filePath ) + " is not an input log" );
+	}
+}
+
+void
+Replayer::attach( CPU& c )
+{
+	cpu = &c;
+}
+
+bool
+Replayer::isReady()
+{
+	return next == events.size() || events[next].instruction <= cpu->getInstructionCount();
+}
+
+int
+Replayer::get()
+{
+	return next < events.size() ? events[next++].value : EOF;
+}
@@ -0,0 +1,43 @@
+#ifndef REPLAY_HH
+#define REPLAY_HH
+
+#include "CPU.hh"
+#include "Input.hh"
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Recorder : public Input
+{
+	public:
+		Recorder( Input& in, const char* filePath );
+		void attach( CPU& c );
+		bool isReady();
+		int get();
+		void wait( const int timeoutMs );
+	private:
+		Input& input;
+		CPU* cpu;
+		std::ofstream log;
+		bool ended;
+};
+
+class Replayer : public Input
+{
+	public:
+		Replayer( const char* filePath );
+		void attach( CPU& c );
+		bool isReady();
+		int get();
+	private:
+		struct Event
+		{
+			unsigned long long instruction;
+			int value;
+		};
+		CPU* cpu;
+		std::vector<Event> events;
+		size_t next;
+};
+
+#endif
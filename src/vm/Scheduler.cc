@@ -0,0 +1,84 @@
+#include "Scheduler.hh"
+#include <chrono>
+#include <exception>
+
+Scheduler::Scheduler( const Engine e, const unsigned long long slice, const unsigned long long max )
+	: engine( e ), quantum( slice > 0 ? slice : 1 ), limit( max ), woken( false ) { }
+
+size_t
+Scheduler::add( CPU& cpu )
+{
+	cpu.setBlocking( false );
+	Task task = { &cpu, cpu.getInstructionCount(), false, cpu.isHalted(), std::string() };
+	tasks.push_back( task );
+	return tasks.size() - 1;
+}
+
+void
+Scheduler::run()
+{
+	bool live = true;
+	while ( live )
+	{
+		live = false;
+		bool ran = false;
+		for ( Task& task : tasks )
+		{
+			if ( task.done )
+			{
+				continue;
+			}
+			live = true;
+			if ( task.parked && !task.cpu->hasInput() )
+			{
+				continue;
+			}
+			ran = true;
+			task.done = runSlice( task );
+			task.parked = !task.done && task.cpu->isWaiting();
+		}
+		if ( live && !ran )
+		{
+			sleep();
+		}
+	}
+}
+
+bool
+Scheduler::runSlice( Task& task )
+{
+	const unsigned long long executed = task.cpu->getInstructionCount() - task.start;
+	const unsigned long long left = limit - executed;
+	try
+	{
+		task.cpu->run( engine, left < quantum ? left : quantum );
+	}
+	catch ( const std::exception& err )
+	{
+		task.error = err.what();
+		return true;
+	}
+	return task.cpu->isHalted() || task.cpu->getInstructionCount() - task.start >= limit;
+}
+
+void
+Scheduler::wake()
+{
+	std::lock_guard<std::mutex> guard( lock );
+	woken = true;
+	changed.notify_one();
+}
+
+void
+Scheduler::sleep()
+{
+	std::unique_lock<std::mutex> guard( lock );
+	changed.wait_for( guard, std::chrono::milliseconds( 10 ), [this] { return woken; } );
+	woken = false;
+}
+
+const std::string&
+Scheduler::getError( const size_t task )
+{
+	return tasks[task].error;
+}
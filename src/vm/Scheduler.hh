@@ -0,0 +1,36 @@
+#ifndef SCHEDULER_HH
+#define SCHEDULER_HH
+
+#include "CPU.hh"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Scheduler
+{
+	public:
+		Scheduler( const Engine e, const unsigned long long slice, const unsigned long long max );
+		size_t add( CPU& cpu );
+		void run();
+		void wake();
+		const std::string& getError( const size_t task );
+	private:
+		struct Task
+		{
+			CPU* cpu;
+			unsigned long long start;
+			bool parked, done;
+			std::string error;
+		};
+		Engine engine;
+		unsigned long long quantum, limit;
+		std::vector<Task> tasks;
+		std::mutex lock;
+		std::condition_variable changed;
+		bool woken;
+		bool runSlice( Task& task );
+		void sleep();
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "CPU.hh"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#define WINDOWS __CYGWIN__ || _WIN32
+
+#if !( WINDOWS )
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
+
+enum
+{
+	SNAPSHOT_VERSION = 1,
+	HEADER_SIZE = 4096,
+	SNAPSHOT_SIZE = HEADER_SIZE + MEM_SIZE * 2
+};
+
+struct SnapshotHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned long long instret;
+	unsigned short GPR[GPR_COUNT];
+	unsigned short PC, PSR;
+	unsigned char halted;
+};
+
+static_assert( sizeof( SnapshotHeader ) <= HEADER_SIZE, "snapshot header must fit in its page" );
+
+void
+CPU::saveSnapshot( const char* filePath )
+{
+	syncPSR();
+	char header[HEADER_SIZE] = { };
+	SnapshotHeader h = SnapshotHeader();
+	std::memcpy( h.magic, "LC3S", 4 );
+	h.version = SNAPSHOT_VERSION;
+	h.instret = instret;
+	std::memcpy( h.GPR, GPR, sizeof GPR );
+	h.PC = PC;
+	h.PSR = PSR;
+	h.halted = halted;
+	std::memcpy( header, &h, sizeof h );
+
+	std::ofstream f( filePath, std::ios::binary );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + std::string( filePath ) );
+	}
+	f.write( header, HEADER_SIZE );
+	f.write( reinterpret_cast<const char*>( mem.data() ), MEM_SIZE * 2 );
+	if ( !f )
+	{
+		throw std::runtime_error( "Can not write: " + std::string( filePath ) );
+	}
+}
+
+void
+CPU::restoreState( const char* filePath, const char* snapshot )
+{
+	SnapshotHeader h;
+	std::memcpy( &h, snapshot, sizeof h );
+	if ( std::memcmp( h.magic, "LC3S", 4 ) != 0 || h.version != SNAPSHOT_VERSION )
+	{
+		throw std::runtime_error( std::string( filePath ) + " is not an LC-3 snapshot" );
+	}
+	instret = h.instret;
+	std::memcpy( GPR, h.GPR, sizeof GPR );
+	PC = h.PC;
+	PSR = h.PSR;
+	ccLazy = false;
+	halted = h.halted;
+	std::memcpy( mem.data(), snapshot + HEADER_SIZE, MEM_SIZE * 2 );
+	std::memset( cache, 0, sizeof cache );
+	discardJIT();
+}
+
+#if WINDOWS
+
+void
+CPU::restoreSnapshot( const char* filePath )
+{
+	std::ifstream f( filePath, std::ios::binary );
+	if ( !f.is_open() )
+	{
+		throw std::runtime_error( "Can not open: " + std::string( filePath ) );
+	}
+	std::string snapshot( SNAPSHOT_SIZE, '\0' );
+	if ( !f.read( &snapshot[0], SNAPSHOT_SIZE ) )
+	{
+		throw std::runtime_error( std::string( filePath ) + " is not an LC-3 snapshot" );
+	}
+	restoreState( filePath, snapshot.data() );
+}
+
+#else
+
+void
+CPU::restoreSnapshot( const char* filePath )
+{
+	const int fd = open( filePath, O_RDONLY );
+	if ( fd < 0 )
+	{
+		throw std::runtime_error( "Can not open: " + std::string( filePath ) );
+	}
+	struct stat st;
+	if ( fstat( fd, &st ) != 0 || st.st_size != SNAPSHOT_SIZE )
+	{
+		close( fd );
+		throw std::runtime_error( std::string( filePath ) + " is not an LC-3 snapshot" );
+	}
+	void* p = mmap( NULL, SNAPSHOT_SIZE, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if ( p == MAP_FAILED )
+	{
+		throw std::runtime_error( "Can not map: " + std::string( filePath ) );
+	}
+	try
+	{
+		restoreState( filePath, static_cast<const char*>( p ) );
+	}
+	catch ( ... )
+	{
+		munmap( p, SNAPSHOT_SIZE );
+		throw;
+	}
+	munmap( p, SNAPSHOT_SIZE );
+}
+
+#endif
@@ -0,0 +1,299 @@
+#include "Trace.hh"
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+#if defined( __SSE2__ )
+
+#include <emmintrin.h>
+
+#endif
+
+static const char* const opcodeNames[] =
+{
+	"BR", "ADD", "LD", "ST", "JSR", "AND", "LDR", "STR",
+	"RTI", "NOT", "LDI", "STI", "JMP", "RES", "LEA", "TRAP"
+};
+
+static const char MAGIC[4] = { 'L', 'C', '3', 'T' };
+
+enum
+{
+	VERSION = 1,
+	JUMP = 0x01,
+	INSTR = 0x02,
+	REGS = 0x04,
+	STORE = 0x08,
+	CC_SHIFT = 4,
+	SEEN = 0x10000
+};
+
+Tracer::Tracer( const char* filePath ) : out( std::fopen( filePath, "wb" ) ), filling( 0 ), pending( 0 ), writing( false ), stopping( false ), GPR(), last( 0 ), lastStore( 0 ), instrs()
+{
+	if ( !out )
+	{
+		throw std::runtime_error( std::string( "Can not open: " ) + filePath );
+	}
+	buffers[0].resize( BUFFER_SIZE );
+	buffers[1].resize( BUFFER_SIZE );
+	pos = buffers[0].data();
+	end = pos + BUFFER_SIZE;
+	writer = std::thread( &Tracer::writerLoop, this );
+}
+
+Tracer::~Tracer()
+{
+	swap();
+	{
+		std::lock_guard<std::mutex> guard( lock );
+		stopping = true;
+	}
+	wake.notify_all();
+	writer.join();
+	std::fclose( out );
+}
+
+void
+Tracer::begin( CPU& cpu )
+{
+	const unsigned long long instret = cpu.getInstructionCount();
+	std::memcpy( pos, MAGIC, sizeof( MAGIC ) );
+	pos += sizeof( MAGIC );
+	*pos++ = VERSION;
+	for ( int i = 0; i < 8; i++ )
+	{
+		*pos++ = static_cast<unsigned char>( instret >> ( i * 8 ) );
+	}
+	for ( int i = 0; i < GPR_COUNT; i++ )
+	{
+		GPR[i] = cpu.getRegister( i );
+		pos = putVarint( pos, GPR[i] );
+	}
+	pos = putVarint( pos, cpu.getPC() );
+	pos = putVarint( pos, cpu.getPSR() );
+	last = cpu.getPC() - 1;
+}
+
+void
+Tracer::record( const unsigned short addr, const unsigned short instr, const unsigned short* gpr, const unsigned short cc, const bool store, const unsigned short storeAddr, const unsigned short storeVal )
+{
+	if ( end - pos < MAX_RECORD )
+	{
+		swap();
+	}
+	unsigned char* p = pos;
+	unsigned char* flags = p++;
+	unsigned char f = cc << CC_SHIFT;
+	if ( addr != static_cast<unsigned short>( last + 1 ) )
+	{
+		f |= JUMP;
+		p = putZigzag( p, static_cast<short>( addr - last - 1 ) );
+	}
+	last = addr;
+	if ( instrs[addr] != ( instr | SEEN ) )
+	{
+		f |= INSTR;
+		*p++ = static_cast<unsigned char>( instr );
+		*p++ = static_cast<unsigned char>( instr >> 8 );
+		instrs[addr] = instr | SEEN;
+	}
+	unsigned int mask = 0;
+#if defined( __SSE2__ )
+	const __m128i same = _mm_cmpeq_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( gpr ) ), _mm_loadu_si128( reinterpret_cast<const __m128i*>( GPR ) ) );
+	mask = ~_mm_movemask_epi8( _mm_packs_epi16( same, same ) ) & 0xFF;
+#else
+	for ( int i = 0; i < GPR_COUNT; i++ )
+	{
+		mask |= ( gpr[i] != GPR[i] ) << i;
+	}
+#endif
+	if ( mask )
+	{
+		f |= REGS;
+		*p++ = static_cast<unsigned char>( mask );
+		for ( int i = 0; i < GPR_COUNT; i++ )
+		{
+			if ( mask & ( 1 << i ) )
+			{
+				p = putZigzag( p, static_cast<short>( gpr[i] - GPR[i] ) );
+			}
+		}
+		std::memcpy( GPR, gpr, sizeof( GPR ) );
+	}
+	if ( store )
+	{
+		f |= STORE;
+		p = putZigzag( p, static_cast<short>( storeAddr - lastStore ) );
+		p = putVarint( p, storeVal );
+		lastStore = storeAddr;
+	}
+	*flags = f;
+	pos = p;
+}
+
+unsigned char*
+Tracer::putVarint( unsigned char* p, const unsigned short val )
+{
+	const unsigned int more = val >= 0x80;
+	const unsigned int most = val >= 0x4000;
+	p[0] = static_cast<unsigned char>( ( val & 0x7F ) | more << 7 );
+	p[1] = static_cast<unsigned char>( ( ( val >> 7 ) & 0x7F ) | most << 7 );
+	p[2] = static_cast<unsigned char>( val >> 14 );
+	return p + 1 + more + most;
+}
+
+unsigned char*
+Tracer::putZigzag( unsigned char* p, const short val )
+{
+	return putVarint( p, static_cast<unsigned short>( ( val << 1 ) ^ ( val >> 15 ) ) );
+}
+
+void
+Tracer::swap()
+{
+	std::unique_lock<std::mutex> guard( lock );
+	wake.wait( guard, [this] { return !writing; } );
+	pending = pos - buffers[filling].data();
+	writing = true;
+	filling ^= 1;
+	pos = buffers[filling].data();
+	end = pos + BUFFER_SIZE;
+	wake.notify_all();
+}
+
+void
+Tracer::writerLoop()
+{
+	std::unique_lock<std::mutex> guard( lock );
+	while ( true )
+	{
+		wake.wait( guard, [this] { return writing || stopping; } );
+		if ( !writing )
+		{
+			break;
+		}
+		const unsigned char* data = buffers[filling ^ 1].data();
+		const size_t length = pending;
+		guard.unlock();
+		std::fwrite( data, 1, length, out );
+		guard.lock();
+		writing = false;
+		wake.notify_all();
+	}
+}
+
+TraceDecoder::TraceDecoder( const char* filePath ) : in( std::string( filePath ) == "-" ? stdin : std::fopen( filePath, "rb" ) )
+{
+	if ( !in )
+	{
+		throw std::runtime_error( std::string( "Can not open: " ) + filePath );
+	}
+}
+
+TraceDecoder::~TraceDecoder()
+{
+	if ( in != stdin )
+	{
+		std::fclose( in );
+	}
+}
+
+void
+TraceDecoder::print( std::ostream& out )
+{
+	char magic[sizeof( MAGIC )];
+	if ( std::fread( magic, 1, sizeof( magic ), in ) != sizeof( magic ) || std::memcmp( magic, MAGIC, sizeof( MAGIC ) ) || next() != VERSION )
+	{
+		throw std::runtime_error( "Not a trace" );
+	}
+	unsigned long long instret = 0;
+	for ( int i = 0; i < 8; i++ )
+	{
+		instret |= static_cast<unsigned long long>( next() ) << ( i * 8 );
+	}
+	unsigned short GPR[GPR_COUNT];
+	for ( int i = 0; i < GPR_COUNT; i++ )
+	{
+		GPR[i] = varint();
+	}
+	const unsigned short pc = varint();
+	const unsigned short psr = varint();
+	std::vector<unsigned short> instrs( MEM_SIZE );
+	unsigned short last = pc - 1, lastStore = 0;
+	out << std::hex << std::uppercase << std::setfill( '0' );
+	out << "start " << std::dec << instret << std::hex << " PC=x" << std::setw( 4 ) << pc << " PSR=x" << std::setw( 4 ) << psr;
+	for ( int i = 0; i < GPR_COUNT; i++ )
+	{
+		out << " R" << i << "=x" << std::setw( 4 ) << GPR[i];
+	}
+	out << '\n';
+	int f;
+	while ( ( f = std::fgetc( in ) ) != EOF )
+	{
+		const unsigned short addr = f & JUMP ? last + 1 + zigzag() : last + 1;
+		last = addr;
+		if ( f & INSTR )
+		{
+			const int low = next();
+			instrs[addr] = low | next() << 8;
+		}
+		const unsigned short instr = instrs[addr];
+		out << std::dec << instret++ << std::hex << " x" << std::setw( 4 ) << addr << " x" << std::setw( 4 ) << instr << ' ' << std::setfill( ' ' ) << std::left << std::setw( 4 ) << opcodeNames[instr >> 12] << std::right << std::setfill( '0' ) << ' ' << ( f & 0x40 ? 'n' : '-' ) << ( f & 0x20 ? 'z' : '-' ) << ( f & 0x10 ? 'p' : '-' );
+		if ( f & REGS )
+		{
+			const int mask = next();
+			for ( int i = 0; i < GPR_COUNT; i++ )
+			{
+				if ( mask & ( 1 << i ) )
+				{
+					GPR[i] += zigzag();
+					out << " R" << i << "=x" << std::setw( 4 ) << GPR[i];
+				}
+			}
+		}
+		if ( f & STORE )
+		{
+			lastStore += zigzag();
+			out << " [x" << std::setw( 4 ) << lastStore << "]=x" << std::setw( 4 ) << varint();
+		}
+		out << '\n';
+	}
+}
+
+int
+TraceDecoder::next()
+{
+	const int c = std::fgetc( in );
+	if ( c == EOF )
+	{
+		throw std::runtime_error( "Trace ends mid-record" );
+	}
+	return c;
+}
+
+unsigned int
+TraceDecoder::varint()
+{
+	unsigned int val = 0;
+	for ( int shift = 0; ; shift += 7 )
+	{
+		const int c = next();
+		if ( shift > 14 )
+		{
+			throw std::runtime_error( "Corrupt trace" );
+		}
+		val |= ( c & 0x7F ) << shift;
+		if ( !( c & 0x80 ) )
+		{
+			return val;
+		}
+	}
+}
+
+short
+TraceDecoder::zigzag()
+{
+	const unsigned int val = varint();
+	return static_cast<short>( ( val >> 1 ) ^ -( val & 1 ) );
+}
@@ -0,0 +1,58 @@
+#ifndef TRACE_HH
+#define TRACE_HH
+
+#include "CPU.hh"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+class Tracer
+{
+	public:
+		Tracer( const char* filePath );
+		~Tracer();
+		void begin( CPU& cpu );
+		void record( const unsigned short addr, const unsigned short instr, const unsigned short* gpr, const unsigned short cc, const bool store, const unsigned short storeAddr, const unsigned short storeVal );
+	private:
+		enum
+		{
+			BUFFER_SIZE = 1 << 20,
+			MAX_RECORD = 64
+		};
+		std::FILE* out;
+		std::vector<unsigned char> buffers[2];
+		unsigned char* pos;
+		unsigned char* end;
+		int filling;
+		size_t pending;
+		bool writing, stopping;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::thread writer;
+		unsigned short GPR[GPR_COUNT];
+		unsigned short last, lastStore;
+		unsigned int instrs[MEM_SIZE];
+		static unsigned char* putVarint( unsigned char* p, const unsigned short val );
+		static unsigned char* putZigzag( unsigned char* p, const short val );
+		void swap();
+		void writerLoop();
+};
+
+class TraceDecoder
+{
+	public:
+		TraceDecoder( const char* filePath );
+		~TraceDecoder();
+		void print( std::ostream& out );
+	private:
+		std::FILE* in;
+		int next();
+		unsigned int varint();
+		short zigzag();
+};
+
+#endif
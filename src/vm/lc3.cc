@@ -0,0 +1,209 @@
+#include "lc3.h"
+#include "CPU.hh"
+#include "Input.hh"
+#include "Console.hh"
+#include "Image.hh"
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	class CallbackInput : public Input
+	{
+		public:
+			CallbackInput( lc3_read_fn fn, void* user ) : read( fn ), readUser( user ), next( LC3_NO_INPUT ) { }
+			bool isReady()
+			{
+				if ( next == LC3_NO_INPUT )
+				{
+					next = read ? read( readUser ) : LC3_EOF;
+				}
+				return next != LC3_NO_INPUT;
+			}
+			int get()
+			{
+				const int c = isReady() ? next : LC3_EOF;
+				next = LC3_NO_INPUT;
+				return c;
+			}
+		private:
+			lc3_read_fn read;
+			void* readUser;
+			int next;
+	};
+}
+
+struct lc3_vm
+{
+	CallbackInput input;
+	Console console;
+	CPU cpu;
+	Engine engine;
+	bool failed;
+	std::string error;
+	lc3_vm( lc3_read_fn read, lc3_write_fn write, void* user ) : input( read, user ), console( write, user ), cpu( input, console ), engine( THREADED_ENGINE ), failed( false )
+	{
+		cpu.setBlocking( false );
+	}
+	int fail( const std::exception& err )
+	{
+		error = err.what();
+		return -1;
+	}
+};
+
+lc3_vm*
+lc3_create( lc3_read_fn read, lc3_write_fn write, void* user )
+{
+	return new ( std::nothrow ) lc3_vm( read, write, user );
+}
+
+void
+lc3_destroy( lc3_vm* vm )
+{
+	delete vm;
+}
+
+void
+lc3_set_engine( lc3_vm* vm, lc3_engine engine )
+{
+	vm->engine = engine == LC3_SWITCH ? SWITCH_ENGINE : engine == LC3_JIT ? JIT_ENGINE : THREADED_ENGINE;
+}
+
+int
+lc3_load_file( lc3_vm* vm, const char* path )
+{
+	try
+	{
+		const Image image( path );
+		vm->cpu.loadImages( { &image } );
+		return 0;
+	}
+	catch ( const std::exception& err )
+	{
+		return vm->fail( err );
+	}
+}
+
+int
+lc3_load( lc3_vm* vm, const unsigned char* data, size_t length )
+{
+	try
+	{
+		const Image image( "image", data, length );
+		vm->cpu.loadImages( { &image } );
+		return 0;
+	}
+	catch ( const std::exception& err )
+	{
+		return vm->fail( err );
+	}
+}
+
+unsigned long long
+lc3_run( lc3_vm* vm, unsigned long long count )
+{
+	const unsigned long long start = vm->cpu.getInstructionCount();
+	if ( !vm->failed )
+	{
+		try
+		{
+			vm->cpu.run( vm->engine, count );
+		}
+		catch ( const std::exception& err )
+		{
+			vm->failed = true;
+			vm->fail( err );
+		}
+		vm->console.flush();
+	}
+	return vm->cpu.getInstructionCount() - start;
+}
+
+lc3_state
+lc3_step( lc3_vm* vm )
+{
+	if ( !vm->failed )
+	{
+		try
+		{
+			vm->cpu.run( SWITCH_ENGINE, 1 );
+		}
+		catch ( const std::exception& err )
+		{
+			vm->failed = true;
+			vm->fail( err );
+		}
+		vm->console.flush();
+	}
+	return lc3_get_state( vm );
+}
+
+lc3_state
+lc3_get_state( lc3_vm* vm )
+{
+	if ( vm->failed )
+	{
+		return LC3_ERROR;
+	}
+	if ( vm->cpu.isHalted() )
+	{
+		return LC3_HALTED;
+	}
+	return vm->cpu.isWaiting() ? LC3_WAITING : LC3_RUNNING;
+}
+
+const char*
+lc3_error( lc3_vm* vm )
+{
+	return vm->error.c_str();
+}
+
+unsigned short
+lc3_read( lc3_vm* vm, unsigned short addr )
+{
+	return vm->cpu.readMemory( addr );
+}
+
+void
+lc3_write( lc3_vm* vm, unsigned short addr, unsigned short val )
+{
+	vm->cpu.writeMemory( addr, val );
+}
+
+unsigned short
+lc3_get_register( lc3_vm* vm, int reg )
+{
+	return vm->cpu.getRegister( reg & ( GPR_COUNT - 1 ) );
+}
+
+void
+lc3_set_register( lc3_vm* vm, int reg, unsigned short val )
+{
+	vm->cpu.setRegister( reg & ( GPR_COUNT - 1 ), val );
+}
+
+unsigned short
+lc3_get_pc( lc3_vm* vm )
+{
+	return vm->cpu.getPC();
+}
+
+void
+lc3_set_pc( lc3_vm* vm, unsigned short addr )
+{
+	vm->cpu.setPC( addr );
+}
+
+unsigned short
+lc3_get_psr( lc3_vm* vm )
+{
+	return vm->cpu.getPSR();
+}
+
+unsigned long long
+lc3_get_instruction_count( lc3_vm* vm )
+{
+	return vm->cpu.getInstructionCount();
+}
@@ -0,0 +1,73 @@
+#ifndef LC3_H
+#define LC3_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ * Each lc3_vm owns its memory, registers, input and output; nothing is shared
+ * between machines, so any number can run at once as long as each one is only
+ * used by one thread at a time. Callbacks run on the calling thread and must not
+ * call back into the machine that invoked them.
+ */
+
+typedef struct lc3_vm lc3_vm;
+
+enum
+{
+	LC3_EOF = -1,
+	LC3_NO_INPUT = -2
+};
+
+typedef enum
+{
+	LC3_SWITCH,
+	LC3_THREADED,
+	LC3_JIT
+} lc3_engine;
+
+typedef enum
+{
+	LC3_RUNNING,
+	LC3_HALTED,
+	LC3_WAITING,
+	LC3_ERROR
+} lc3_state;
+
+/* Returns the next key (0-255), LC3_NO_INPUT if none is available yet, or LC3_EOF. */
+typedef int ( *lc3_read_fn )( void* user );
+typedef void ( *lc3_write_fn )( void* user, const char* data, size_t length );
+
+lc3_vm* lc3_create( lc3_read_fn read, lc3_write_fn write, void* user );
+void lc3_destroy( lc3_vm* vm );
+void lc3_set_engine( lc3_vm* vm, lc3_engine engine );
+
+/* Return 0 on success and -1 on failure, with the reason in lc3_error. */
+int lc3_load_file( lc3_vm* vm, const char* path );
+int lc3_load( lc3_vm* vm, const unsigned char* data, size_t length );
+
+/* Return the number of instructions executed, stopping early when the program
+   halts, fails or waits on GETC/IN for input that is not there yet. */
+unsigned long long lc3_run( lc3_vm* vm, unsigned long long count );
+lc3_state lc3_step( lc3_vm* vm );
+lc3_state lc3_get_state( lc3_vm* vm );
+const char* lc3_error( lc3_vm* vm );
+
+unsigned short lc3_read( lc3_vm* vm, unsigned short addr );
+void lc3_write( lc3_vm* vm, unsigned short addr, unsigned short val );
+unsigned short lc3_get_register( lc3_vm* vm, int reg );
+void lc3_set_register( lc3_vm* vm, int reg, unsigned short val );
+unsigned short lc3_get_pc( lc3_vm* vm );
+void lc3_set_pc( lc3_vm* vm, unsigned short addr );
+unsigned short lc3_get_psr( lc3_vm* vm );
+unsigned long long lc3_get_instruction_count( lc3_vm* vm );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,24 +1,266 @@
 #include "CPU.hh"
+#include "Batch.hh"
+#include "Bench.hh"
+#include "Keyboard.hh"
+#include "Monitor.hh"
+#include "Console.hh"
+#include "Profiler.hh"
+#include "Replay.hh"
+#include "Trace.hh"
 #include "platform.hh"
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <signal.h>
-#include <iomanip>
+#include <climits>
+#include <string>
+#include <thread>
+#include <vector>
+
+int usage()
+{
+	std::cerr << "usage: ./main [-e engine] [-n count] [-r snapshot] [-s snapshot] [-p report] [-x trace] [-m name] [-u addr] [-w log | -i log] bin1 [bin2 ...]\n"
+		<< "       ./main [-e engine] [-n count] [-j threads] [-q quantum] -b manifest outdir\n"
+		<< "       ./main [-e engine] [-k runs] -t suite\n"
+		<< "       ./main -d trace\n"
+		<< "       bin1, bin2, etc.: path to an assembled LC-3 program\n"
+		<< "       engine: threaded (default), switch, jit or lockstep\n"
+		<< "               lockstep runs up to 16 -b runs of the same bins side by side, otherwise it is switch\n"
+		<< "       count: maximum number of instructions to execute per program\n"
+		<< "       -r snapshot: resume from a snapshot instead of starting at x3000, bins are optional\n"
+		<< "       -s snapshot: save the machine state when the program halts or reaches count\n"
+		<< "       -p report: profile with the switch engine and write the hottest code to report,\n"
+		<< "                  labelled from the .sym file next to each bin\n"
+		<< "       -x trace: write a compact binary trace of every instruction to trace, using the switch engine\n"
+		<< "       -m name: publish live counters in shared memory name for the monitor, using the switch engine\n"
+		<< "       -d trace: print trace as text, one instruction per line, - to read stdin\n"
+		<< "       -u addr: stop before the instruction at hex address addr, e.g. x3010, using the switch engine;\n"
+		<< "                repeat to stop at any of several addresses\n"
+		<< "       -w log: record each key read, with the instruction count it was read at, to log\n"
+		<< "       -i log: replay the keys in log at the recorded instruction counts instead of reading stdin\n"
+		<< "       manifest: one run per line, \"stdin-file bin1 [bin2 ...]\", - for no input\n"
+		<< "       threads: number of worker threads for -b, one per core by default\n"
+		<< "       quantum: time-slice the runs of each thread round-robin, quantum instructions per slice\n"
+		<< "       outdir: existing directory that receives N.out per run and results.tsv\n"
+		<< "       suite: one workload per line, \"name count|- stdin-file|- bin1 [bin2 ...]\", e.g. progs/bench.txt\n"
+		<< "       runs: timed runs per workload, 5 by default; results go to stdout as tab-separated values\n";
+	return 1;
+}
 
 int main( int argc, char* argv[] )
 {
-	if ( argc == 1 )
+	Engine engine = THREADED_ENGINE;
+	unsigned long long limit = ULLONG_MAX;
+	unsigned int threads = std::thread::hardware_concurrency();
+	unsigned long long quantum = 0;
+	unsigned int runs = 5;
+	const char* manifest = NULL;
+	const char* restore = NULL;
+	const char* save = NULL;
+	const char* report = NULL;
+	const char* suite = NULL;
+	const char* record = NULL;
+	const char* replay = NULL;
+	const char* trace = NULL;
+	const char* decode = NULL;
+	const char* monitorName = NULL;
+	std::vector<unsigned short> breakpoints;
+	int i = 1;
+	for ( ; i + 1 < argc && argv[i][0] == '-'; i += 2 )
+	{
+		const std::string opt = argv[i];
+		const std::string arg = argv[i + 1];
+		if ( opt == "-e" && arg == "switch" )
+		{
+			engine = SWITCH_ENGINE;
+		}
+		else if ( opt == "-e" && arg == "jit" )
+		{
+			engine = JIT_ENGINE;
+		}
+		else if ( opt == "-e" && arg == "lockstep" )
+		{
+			engine = LOCKSTEP_ENGINE;
+		}
+		else if ( opt == "-e" && arg == "threaded" )
+		{
+			engine = THREADED_ENGINE;
+		}
+		else if ( opt == "-n" )
+		{
+			limit = std::stoull( arg );
+		}
+		else if ( opt == "-j" )
+		{
+			threads = std::stoul( arg );
+		}
+		else if ( opt == "-q" )
+		{
+			quantum = std::stoull( arg );
+		}
+		else if ( opt == "-w" )
+		{
+			record = argv[i + 1];
+		}
+		else if ( opt == "-i" )
+		{
+			replay = argv[i + 1];
+		}
+		else if ( opt == "-x" )
+		{
+			trace = argv[i + 1];
+		}
+		else if ( opt == "-m" )
+		{
+			monitorName = argv[i + 1];
+		}
+		else if ( opt == "-u" )
+		{
+			breakpoints.push_back( std::stoul( arg.substr( arg[0] == 'x' ), NULL, 16 ) );
+		}
+		else if ( opt == "-d" )
+		{
+			decode = argv[i + 1];
+		}
+		else if ( opt == "-k" )
+		{
+			runs = std::stoul( arg );
+		}
+		else if ( opt == "-t" )
+		{
+			suite = argv[i + 1];
+		}
+		else if ( opt == "-b" )
+		{
+			manifest = argv[i + 1];
+		}
+		else if ( opt == "-r" )
+		{
+			restore = argv[i + 1];
+		}
+		else if ( opt == "-s" )
+		{
+			save = argv[i + 1];
+		}
+		else if ( opt == "-p" )
+		{
+			report = argv[i + 1];
+		}
+		else
+		{
+			return usage();
+		}
+	}
+	if ( decode )
+	{
+		if ( i != argc )
+		{
+			return usage();
+		}
+		TraceDecoder decoder( decode );
+		decoder.print( std::cout );
+		return 0;
+	}
+	if ( suite )
+	{
+		if ( i != argc )
+		{
+			return usage();
+		}
+		Bench bench( engine, runs );
+		return bench.run( suite, std::cout );
+	}
+	if ( manifest )
 	{
-		std::cerr << "usage: ./main bin1 [bin2 ...]\n" << std::setw( 59 ) << "bin1, bin2, etc.: path to an assembled LC-3 program\n";
-		return 1;
+		if ( i + 1 != argc )
+		{
+			return usage();
+		}
+		Batch batch( engine, limit, threads, quantum );
+		return batch.run( manifest, argv[i] );
+	}
+	if ( ( i == argc && !restore ) || ( record && replay ) )
+	{
+		return usage();
 	}
 	signal( SIGINT, handleInterrupt );
 	disableBuffering();
-	CPU cpu;
-	cpu.loadPrograms( argc, argv );
-	while ( !cpu.isHalted() )
+	std::unique_ptr<Replayer> replayer;
+	std::unique_ptr<Recorder> recorder;
+	Input* input;
+	if ( replay )
+	{
+		replayer.reset( new Replayer( replay ) );
+		input = replayer.get();
+	}
+	else
+	{
+		// The reader thread stays blocked on stdin until exit, so the keyboard is never freed.
+		input = new Keyboard();
+		if ( record )
+		{
+			recorder.reset( new Recorder( *input, record ) );
+			input = recorder.get();
+		}
+	}
+	Console console( stdout, true );
+	CPU cpu( *input, console );
+	if ( replayer )
+	{
+		replayer->attach( cpu );
+	}
+	if ( recorder )
+	{
+		recorder->attach( cpu );
+	}
+	cpu.setExactCount( record || replay );
+	if ( restore )
+	{
+		cpu.restoreSnapshot( restore );
+	}
+	const std::vector<std::string> images( argv + i, argv + argc );
+	cpu.loadPrograms( images );
+	Profiler profiler;
+	if ( report )
+	{
+		for ( const std::string& image : images )
+		{
+			profiler.loadSymbols( image.substr( 0, image.rfind( '.' ) ) + ".sym" );
+		}
+		cpu.setProfiler( &profiler );
+	}
+	for ( const unsigned short addr : breakpoints )
+	{
+		cpu.setBreakpoint( addr );
+	}
+	std::unique_ptr<Tracer> tracer;
+	if ( trace )
+	{
+		tracer.reset( new Tracer( trace ) );
+		cpu.setTracer( tracer.get() );
+	}
+	std::unique_ptr<Monitor> monitor;
+	if ( monitorName )
+	{
+		monitor.reset( new Monitor( monitorName, true ) );
+		cpu.setMonitor( monitor.get() );
+		monitor->setState( Monitor::RUNNING );
+	}
+	cpu.run( engine, limit );
+	if ( monitor )
+	{
+		console.flush();
+		monitor->publish( cpu.getPC(), console.getBytesWritten() );
+		monitor->setState( cpu.isHalted() ? Monitor::HALTED : Monitor::STOPPED );
+	}
+	if ( save )
+	{
+		cpu.saveSnapshot( save );
+	}
+	if ( report )
 	{
-		unsigned short instr = cpu.fetchInstr();
-		cpu.handleInstr( instr );
+		std::ofstream f( report );
+		profiler.report( f );
 	}
 	restoreBuffering();
 	return 0;